@@ -12,6 +12,7 @@
 #include <string_view>
 #include <vector>
 
+#include "arc.h"
 #include "rack.h"
 #include "rec.h"
 
@@ -26,84 +27,244 @@ class RField;
 using qfields_t = std::vector<const QField*>;
 using qtusedmap_t = std::map<sv, const QTable*>;
 
+/**
+ * @brief Джерело значення параметра $n - крок плану прив'язки.
+ * @details SqlGenius кешує план поряд з текстом SQL і при влучанні бере значення
+ * за планом, не проходячи генератор. Для filter index - номер фільтра, sub - номер
+ * значення в ньому; для seek index - номер ключа; для join - таблиця "розумного" JOIN.
+ */
+struct SqlBind {
+  enum class From : char { join, filter, seek, limit, offset, id, ids };
+  From from;
+  size_t index = 0;
+  size_t sub = 0;
+  const void* table = nullptr;
+};
+
+/**
+ * @brief Текст SQL з позиційними параметрами $1..$n, що нумеруються під час генерації.
+ * @details Значення параметрів додаються в params у порядку появи в тексті.
+ * З plan кожен параметр має вказати джерело (SqlBind): так SqlGenius будує текст
+ * для кешу форм, а при влучанні заповнює params лише за планом.
+ */
+class SqlBuilder {
+public:
+  explicit SqlBuilder(std::vector<std::string>& params, std::vector<SqlBind>* plan = nullptr)
+      : params_(params), plan_(plan) {}
+
+  template <typename T>
+  SqlBuilder& operator<<(const T& v) {
+    ss_ << v;
+    return *this;
+  }
+
+  /// Додає значення параметра і пише його позицію, напр. "$3". Лише без плану.
+  SqlBuilder& param(std::string value) {
+    if (plan_) throw std::logic_error("SqlBuilder: a cached query parameter needs its SqlBind.");
+    params_.push_back(std::move(value));
+    ss_ << '$' << params_.size();
+    return *this;
+  }
+
+  /// Те саме, із джерелом значення для плану прив'язки.
+  SqlBuilder& param(const SqlBind& bind, std::string value) {
+    if (plan_) plan_->push_back(bind);
+    params_.push_back(std::move(value));
+    ss_ << '$' << params_.size();
+    return *this;
+  }
+
+  /// Повторно посилається на вже доданий параметр, напр. "$1".
+  SqlBuilder& ref(size_t pos) {
+    ss_ << '$' << pos;
+    return *this;
+  }
+
+  /// Позиція останнього доданого параметра.
+  size_t last() const { return params_.size(); }
+
+  std::string str() const { return ss_.str(); }
+
+private:
+  std::vector<std::string>& params_;
+  std::vector<SqlBind>* plan_;
+  std::stringstream ss_;
+};
+
 /**
  * @brief Допоміжний клас для розбору одного рядка фільтра.
  * @details Інкапсулює логіку перетворення рядка типу ">100|20:30"
  * в готовий до використання SQL-блок та набір параметрів.
+ * Розбір дає лише оператори та значення; текст SQL пише write(),
+ * тобто лише при промаху кешу форм SqlGenius.
+ * Предикати залежать від type_t поля: для int/date/ref - рівність, IN та діапазони
+ * з типізованими параметрами (їх бере btree-індекс), LIKE за префіксом - лише для тексту.
+ * Значення, що не відповідає типу, відхиляється одразу, без запиту до БД.
+ * Поля без типізації (bin_t::none: timestamp, numeric...) не перевіряються і не приводяться:
+ * оператори порівняння йдуть як є, просте значення - LIKE за префіксом по column::text.
  */
 class FilterParser {
 public:
   /**
    * @brief Конструктор, який одразу виконує парсинг.
    * @param filter Об'єкт фільтра з Recordset, що містить поле та рядок значень.
+   * @throws std::invalid_argument Значення не відповідає типу поля.
    */
   explicit FilterParser(const Recordset::Filter& filter) : input_filter_(filter) { parse(); }
 
-  /// Повертає згенерований SQL-блок, напр. "(t1.status LIKE $f_0 OR t1.amount > $f_1)"
-  const std::string& getSql() const { return sql_clause_; }
+  /// Пише SQL-блок з параметрами, напр. "(t1.year IN ($1::int, $2::int) OR t1.year > $3::int)"
+  /// @param index Номер фільтра - джерело його параметрів у плані прив'язки.
+  void write(SqlBuilder& sb, size_t index) const {
+    const auto& qfield = input_filter_.rfield.qfield;
+    size_t n = 0;
+    sb << "(";
+    for (size_t i = 0; i < terms_.size(); ++i) {
+      const Term& term = terms_[i];
+      if (i) sb << " OR ";
+      sb << qfield.pqt->alias << "." << qfield.pf->sqlName();
+      if (term.op == Op::LIKE && untyped_) sb << "::text";
+      switch (term.op) {
+        case Op::EQ: sb << " = "; break;
+        case Op::IN: sb << " IN ("; break;
+        case Op::NE: sb << " != "; break;
+        case Op::GT: sb << " > "; break;
+        case Op::LT: sb << " < "; break;
+        case Op::BETWEEN: sb << " BETWEEN "; break;
+        case Op::LIKE: sb << " LIKE "; break;
+      }
+      for (size_t v = 0; v < term.values.size(); ++v) {
+        if (v) sb << (term.op == Op::BETWEEN ? " AND " : ", ");
+        sb.param({SqlBind::From::filter, index, n++}, term.values[v]) << cast_;
+      }
+      if (term.op == Op::IN) sb << ")";
+    }
+    sb << ")";
+  }
 
-  /// Повертає параметри, що належать тільки цьому блоку.
-  const std::map<std::string, std::string>& getParams() const { return params_; }
+  /// Форма блоку для ключа кешу: коди операторів без значень, напр. "I3>B".
+  const std::string& getShape() const { return shape_; }
+
+  /// n-те значення параметра в порядку write().
+  const std::string& value(size_t n) const {
+    for (const Term& term : terms_) {
+      if (n < term.values.size()) return term.values[n];
+      n -= term.values.size();
+    }
+    throw std::out_of_range("FilterParser: no such parameter.");
+  }
 
 private:
+  enum class Op : char { EQ = '=', IN = 'I', NE = '!', GT = '>', LT = '<', BETWEEN = 'B', LIKE = 'L' };
+  struct Term {
+    Op op;
+    std::vector<std::string> values;  // IN - усі значення, BETWEEN - дві межі
+  };
+
   void parse() {
-    std::stringstream ss;
-    const auto& full_field_name =
-        input_filter_.rfield.qfield.pqt->alias + "." + input_filter_.rfield.qfield.pf->sqlName();
+    const type_t& type = *input_filter_.rfield.qfield.pf->type;
+    untyped_ = type.bin() == type_t::bin_t::none;
+    // Значення нетипізованого поля перевіряє лише сервер, тож розбір - як для тексту
+    const bool textual = type.bin() == type_t::bin_t::text || untyped_;
+    switch (type.bin()) {
+      case type_t::bin_t::int32: cast_ = "::int"; break;
+      case type_t::bin_t::date: cast_ = "::date"; break;
+      default: break;
+    }
 
     std::string value_str(input_filter_.value);
     std::stringstream value_stream(value_str);
     std::string segment;
-    bool first_or = true;
-
-    ss << "(";
+    std::vector<std::string> equals;  // Прості значення не-текстового поля - один IN
 
     while (std::getline(value_stream, segment, '|')) {
       if (segment.empty()) continue;
 
-      if (!first_or) {
-        ss << " OR ";
-      }
-      first_or = false;
-
-      std::string param_name = "f_" + std::to_string(local_param_counter_++);
+      Term term{Op::LIKE, {}};
 
       // Визначення оператора
       if (segment.rfind("!=", 0) == 0) {
-        ss << full_field_name << " != $" << param_name;
-        params_[param_name] = segment.substr(2);
+        term.op = Op::NE;
+        term.values.push_back(segment.substr(2));
       } else if (segment[0] == '>') {
-        ss << full_field_name << " > $" << param_name;
-        params_[param_name] = segment.substr(1);
+        term.op = Op::GT;
+        term.values.push_back(segment.substr(1));
       } else if (segment[0] == '<') {
-        ss << full_field_name << " < $" << param_name;
-        params_[param_name] = segment.substr(1);
+        term.op = Op::LT;
+        term.values.push_back(segment.substr(1));
       } else {
         auto pos = segment.find(':');
         if (pos != std::string::npos) {
-          std::string param_name2 = "f_" + std::to_string(local_param_counter_++);
-          ss << full_field_name << " BETWEEN $" << param_name << " AND $" << param_name2;
-          params_[param_name] = segment.substr(0, pos);
-          params_[param_name2] = segment.substr(pos + 1);
+          term.op = Op::BETWEEN;
+          term.values.push_back(segment.substr(0, pos));
+          term.values.push_back(segment.substr(pos + 1));
+        } else if (textual) {
+          term.values.push_back(segment + "%");
         } else {
-          ss << full_field_name << " LIKE $" << param_name;
-          params_[param_name] = segment + "%";
+          check(segment);
+          equals.push_back(std::move(segment));
+          continue;
         }
       }
+      if (!textual) {
+        for (const auto& v : term.values) check(v);
+      }
+      terms_.push_back(std::move(term));
+    }
+
+    if (!equals.empty()) {
+      Op op = equals.size() == 1 ? Op::EQ : Op::IN;
+      terms_.insert(terms_.begin(), Term{op, std::move(equals)});
+    }
+    for (const Term& term : terms_) {
+      shape_.push_back(static_cast<char>(term.op));
+      if (term.op == Op::IN) shape_ += std::to_string(term.values.size());
+    }
+  }
+
+  /// Значення не-текстового поля, що не пройшло type_t::validate, не збіжеться з жодним рядком.
+  void check(const std::string& value) const {
+    const auto& field = *input_filter_.rfield.qfield.pf;
+    if (value.empty() || !field.type->validate(value)) {
+      throw std::invalid_argument("FilterParser: value '" + value + "' is not valid for field '" + field.name +
+                                  "' of type " + field.type->name);
     }
-    ss << ")";
-    sql_clause_ = ss.str();
   }
 
   const Recordset::Filter& input_filter_;
-  std::string sql_clause_;
-  std::map<std::string, std::string> params_;
-  int local_param_counter_ = 0;
+  std::vector<Term> terms_;
+  std::string shape_;
+  const char* cast_ = "";  // приведення параметра до типу колонки, напр. "::int"
+  bool untyped_ = false;   // type_t::bin_t::none - без перевірки і приведення
+};
+
+/**
+ * @brief Ключ кешу форм SQL (SqlGenius::shape_cache).
+ * @details Байти вказівників на метадані (QModel, QField, QTable) та коди, що впливають
+ * на текст SQL, без значень параметрів. Метадані Rack живуть увесь час роботи процесу,
+ * тож вказівники однозначно ідентифікують форму для всіх сесій.
+ */
+class SqlShapeKey {
+public:
+  explicit SqlShapeKey(char kind) { key_.push_back(kind); }
+
+  void add(const void* p) { key_.append(reinterpret_cast<const char*>(&p), sizeof(p)); }
+  void add(char c) { key_.push_back(c); }
+  void add(size_t n) { key_.append(reinterpret_cast<const char*>(&n), sizeof(n)); }
+  void add(std::string_view s) {
+    add(s.size());  // довжина - щоб сусідні рядки не склеювались у той самий ключ
+    key_.append(s);
+  }
+
+  const std::string& str() const { return key_; }
+
+private:
+  std::string key_;
 };
 
 /**
  * @brief Клас, що генерує SQL. Є friend-класом для Record та Recordset.
- * Підтримує 3-кроковий процес завантаження для Recordset та динамічний набір полів.
+ * Підтримує завантаження Recordset (COUNT і сторінка одним пакетом) та динамічний набір полів.
+ * Кожен gen_* метод пише в SQL позиційні $1..$n і заповнює params() у тому ж порядку.
  */
 class SqlGenius {
 public:
@@ -121,222 +282,437 @@ public:
    * @details Цей метод призначений для сценаріїв, коли потрібно завантажити
    * дані для одного конкретного запису за його ID.
    * Він не використовується
-   * для Recordset, оскільки для них застосовується 3-кроковий процес завантаження.
+   * для Recordset, оскільки для них є gen_select_count() і gen_select_page().
    * @param fields_to_load Вектор полів, які потрібно завантажити.
    * @return Рядок з готовим SQL-запитом.
    */
   std::string gen_select_one(const vector_prf& fields_to_load) {
+    params.clear();
     if (fields_to_load.empty()) return "";
-    namedParams.clear();
-    std::stringstream ss;
 
     qfields_t qfields;
     qtusedmap_t used_tables;
     build_clauses_from_fields(fields_to_load, qfields, used_tables);
 
-    sql_clause_select(ss, qfields);
-    sql_clause_from(ss, used_tables);
-    sql_clause_where_id(ss);
-    namedParams["id"] = getIdFieldValue();
-    ss << ";";
-    return ss.str();
+    SqlShapeKey key = shape_key('1', qfields, used_tables);
+    return cached_sql(key, [&](SqlBuilder& sb) {
+      sql_clause_select(sb, qfields);
+      sql_clause_from(sb, used_tables);
+      sql_clause_where_id(sb);
+      sb << ";";
+    });
   }
 
   std::string gen_insert() {
-    namedParams.clear();
-    const auto& rkey = record->rkey;
-    const auto* mtable = rkey.tgtQModel;
-
-    std::stringstream columns, values;
-    bool first = true;
-    for (const auto& rf_ptr : record->rfields) {
-      if (rf_ptr->qfield.pqt != mtable || !rf_ptr->is_modified || rf_ptr->qfield.pf->name == "id") continue;
-      if (!first) {
-        columns << ", ";
-        values << ", ";
-      }
-      first = false;
-      const auto& param_name = rf_ptr->qfield.pf->sqlName();
-      columns << param_name;
-      values << "$" << param_name;
-      namedParams[param_name] = std::string(rf_ptr->val);
+    params.clear();
+    SqlBuilder sb(params);
+    if (!sql_insert(sb)) {
+      params.clear();
+      return "";  // No fields to insert
     }
+    sb << " RETURNING id;";
+    return sb.str();
+  }
 
-    if (first) return "";  // No fields to insert
+  /**
+   * @brief Список колонок, які запише gen_insert(), напр. "name, city_id".
+   * @details Ключ групування нових записів однієї QModel для gen_insert_rows().
+   * @return Порожній рядок, якщо вставляти нічого.
+   */
+  std::string insert_columns() const {
+    std::string columns;
+    for (const auto& rf : record->rfields.all()) {
+      if (!is_insert_field(rf)) continue;
+      if (!columns.empty()) columns += ", ";
+      columns += rf.qfield.pf->sqlName();
+    }
+    return columns;
+  }
 
-    std::stringstream ss;
-    ss << "INSERT INTO " << mtable->pt->name << " (" << columns.str() << ") VALUES (" << values.str()
-       << ") RETURNING id;";
-    return ss.str();
+  /**
+   * @brief Генерує один INSERT ... RETURNING id для кількох нових записів (Record::SaveBatch).
+   * @details Усі записи мають ту саму QModel і ті самі insert_columns(), що й record.
+   * Рядки RETURNING повертаються в порядку VALUES.
+   * @param rows Нові записи; record має бути серед них або мати ту ж форму.
+   * @return Рядок з готовим SQL-запитом.
+   */
+  std::string gen_insert_rows(const std::vector<Record*>& rows) {
+    params.clear();
+    const std::string columns = insert_columns();
+    if (columns.empty() || rows.empty()) return "";
+
+    SqlBuilder sb(params);
+    sb << "INSERT INTO " << record->rkey.tgtQModel->pt->name << " (" << columns << ") VALUES ";
+    for (size_t r = 0; r < rows.size(); ++r) {
+      sb << (r ? ", (" : "(");
+      bool first = true;
+      for (const auto& rf : rows[r]->rfields.all()) {
+        if (!is_insert_field(rf)) continue;
+        if (!first) sb << ", ";
+        sb.param(std::string(rf.val));
+        first = false;
+      }
+      sb << ")";
+    }
+    sb << " RETURNING id;";
+    return sb.str();
   }
 
+  /// UPDATE ... RETURNING id: порожній результат - запису вже немає.
   std::string gen_update() {
-    namedParams.clear();
-    const auto& rkey = record->rkey;
-    const auto* mtable = rkey.tgtQModel;
-    std::stringstream set_clause;
-    bool first = true;
-    for (const auto& rf_ptr : record->rfields) {
-      if (rf_ptr->qfield.pqt != mtable || !rf_ptr->is_modified || rf_ptr->qfield.pf->name == "id") continue;
-      if (!first) set_clause << ", ";
-      first = false;
-
-      const auto& param_name = rf_ptr->qfield.pf->sqlName();
-      set_clause << param_name << " = $" << param_name;
-      namedParams[param_name] = std::string(rf_ptr->val);
+    params.clear();
+    SqlBuilder sb(params);
+    if (!sql_update(sb)) {  // No fields to update
+      params.clear();
+      return "";
     }
+    sb << " RETURNING " << record->rkey.tgtQModel->alias << ".id;";
+    return sb.str();
+  }
 
-    if (first) return "";  // No fields to update
-
-    std::stringstream ss;
-    ss << "UPDATE " << mtable->pt->name << " SET " << set_clause.str();
-    sql_clause_where_id(ss);
-    namedParams["id"] = getIdFieldValue();
+  /**
+   * @brief Генерує INSERT чи UPDATE разом з read-after-write одним запитом (Record::Save).
+   * @details Запис іде в CTE з RETURNING *, тож значення тригерів і DEFAULT вже в ньому;
+   * поля приєднаних таблиць (напр. author.full_name) - через LEFT JOIN до CTE у тому ж запиті.
+   * JOIN-и стандартні: змінений FK вже в рядку CTE. Першою колонкою йде id головної таблиці.
+   * @param fields_to_load Поля, які треба перечитати після запису.
+   * @return Порожній рядок, якщо записувати нічого.
+   */
+  std::string gen_save(const vector_prf& fields_to_load) {
+    params.clear();
+    SqlBuilder sb(params);
+    sb << "WITH saved AS (\n";
+    if (!(record->is_new ? sql_insert(sb) : sql_update(sb))) {
+      params.clear();
+      return "";
+    }
+    sb << "\nRETURNING *\n)\n";
 
-    ss << ";";
-    return ss.str();
+    qfields_t qfields;
+    qtusedmap_t used_tables;
+    build_clauses_from_fields(fields_to_load, qfields, used_tables);
+    sql_clause_select(sb, qfields, true);
+    smart_joins = false;
+    sql_clause_from(sb, used_tables, "saved");
+    smart_joins = true;
+    sb << ";";
+    return sb.str();
   }
 
   std::string gen_delete() {
-    namedParams.clear();
+    params.clear();
     const auto& rkey = record->rkey;
     const auto* mtable = rkey.tgtQModel;
-    std::stringstream ss;
-    ss << "DELETE FROM " << mtable->pt->name;
+    SqlBuilder sb(params);
+    sb << "DELETE FROM " << mtable->pt->name;
 
-    sql_clause_where_id(ss);
-    namedParams["id"] = getIdFieldValue();
+    sql_clause_where_id(sb);
 
-    ss << ";";
-    return ss.str();
+    sb << ";";
+    return sb.str();
   }
 
   /**
    * @brief Генерує запит DELETE для списку ID.
+   * @details ID йдуть одним параметром-масивом, тож текст не залежить від їх кількості.
    * @param ids Вектор ID записів, які потрібно видалити.
-   * @return Рядок з готовим SQL-запитом "DELETE ... WHERE id IN (...)".
+   * @return Рядок з готовим SQL-запитом "DELETE ... WHERE id = ANY($1::int[])".
    */
   std::string gen_delete_by_ids(const std::vector<std::string>& ids) {
+    params.clear();
     if (ids.empty()) return "";
-    namedParams.clear();
 
     const auto* mtable = record->rkey.tgtQModel;
-    std::stringstream ss;
-    ss << "DELETE FROM " << mtable->pt->name;
+    SqlBuilder sb(params);
+    sb << "DELETE FROM " << mtable->pt->name;
 
-    ss << "\nWHERE id IN (";
-    bool first = true;
-    for (size_t i = 0; i < ids.size(); ++i) {
-      if (!first) ss << ", ";
-      first = false;
+    sb << "\nWHERE id";
+    sql_id_any(sb, ids);
+    sb << ";";
 
-      // Використовуємо префікс 'id_' для уникнення конфліктів
-      std::string param_name = "id_" + std::to_string(i);
-      ss << "$" << param_name;
-      namedParams[param_name] = ids[i];
-    }
-    ss << ");";
-
-    return ss.str();
+    return sb.str();
   }
 
-  // --- Методи для Recordset (3-крокове завантаження) ---
+  // --- Методи для Recordset (COUNT і сторінка) ---
 
   std::string gen_select_count() {
     if (!recordset) throw std::logic_error("gen_select_count can only be called for a Recordset.");
-    namedParams.clear();
+    params.clear();
 
     qtusedmap_t used_tables;
     const auto* mtable = recordset->rkey.tgtQModel;
     used_tables.try_emplace(mtable->alias, mtable);
     add_tables_from_filters(used_tables);
 
-    std::stringstream ss;
-    ss << "SELECT COUNT(" << mtable->alias << ".id)";
-    sql_clause_from(ss, used_tables);
-    sql_clause_where_filters(ss);
-    ss << ";";
-    return ss.str();
+    SqlShapeKey key = shape_key('c', {}, used_tables);
+    return cached_sql(key, [&](SqlBuilder& sb) {
+      sb << "SELECT COUNT(" << mtable->alias << ".id)";
+      sql_clause_from(sb, used_tables);
+      sql_clause_where_filters(sb);
+      sb << ";";
+    });
   }
 
-  std::string gen_select_ids() {
-    if (!recordset) throw std::logic_error("gen_select_ids can only be called for a Recordset.");
-    namedParams.clear();
+  /**
+   * @brief Генерує EXPLAIN вибірки id за фільтрами - оцінку кількості записів планувальником.
+   * @details Перший рядок плану містить "rows=N". Без фільтрів це pg_class.reltuples,
+   * приведене планувальником до поточного розміру таблиці.
+   * @return Рядок з готовим SQL-запитом.
+   */
+  std::string gen_estimate_count() {
+    if (!recordset) throw std::logic_error("gen_estimate_count can only be called for a Recordset.");
+    params.clear();
 
     qtusedmap_t used_tables;
     const auto* mtable = recordset->rkey.tgtQModel;
     used_tables.try_emplace(mtable->alias, mtable);
     add_tables_from_filters(used_tables);
+
+    SqlShapeKey key = shape_key('e', {}, used_tables);
+    return cached_sql(key, [&](SqlBuilder& sb) {
+      sb << "EXPLAIN SELECT " << mtable->alias << ".id";
+      sql_clause_from(sb, used_tables);
+      sql_clause_where_filters(sb);
+      sb << ";";
+    });
+  }
+
+  /**
+   * @brief Генерує запит сторінки: поля, а за ними id головної таблиці та ключі сортування.
+   * @details Колонки після fields_to_load - "_ky_id", далі "_ky_k0", "_ky_k1"... за sorts -
+   * дають id сторінки і її межі для keyset, тож окремого запиту id немає і COUNT та сторінку
+   * можна відправити одним пакетом (SqlDB::query_pipeline). Попередня сторінка (Seek::PREV)
+   * обирається у зворотному порядку, а зовнішній запит повертає їй порядок Recordset.
+   * @param fields_to_load Вектор полів, які потрібно завантажити; порожній - лише id і ключі.
+   * @return Рядок з готовим SQL-запитом.
+   */
+  std::string gen_select_page(const vector_prf& fields_to_load) {
+    if (!recordset) throw std::logic_error("gen_select_page can only be called for a Recordset.");
+    params.clear();
+
+    qfields_t qfields;
+    qtusedmap_t used_tables;
+    build_clauses_from_fields(fields_to_load, qfields, used_tables);
+    add_tables_from_filters(used_tables);
     add_tables_from_sorts(used_tables);
 
-    std::stringstream ss;
-    ss << "SELECT " << mtable->alias << ".id";
-    sql_clause_from(ss, used_tables);
-    sql_clause_where_filters(ss);
-    sql_clause_sort(ss);
-    sql_clause_pager(ss);
-    ss << ";";
-    return ss.str();
+    SqlShapeKey key = shape_key('p', qfields, used_tables);
+    return cached_sql(key, [&](SqlBuilder& sb) {
+      const bool prev = recordset->seeking() && recordset->seek == Recordset::Seek::PREV;
+      const auto keys = order_keys();  // поля сортування, останнім - id
+      auto key_column = [&](size_t i) { return i + 1 < keys.size() ? "_ky_k" + std::to_string(i) : std::string("_ky_id"); };
+
+      if (prev) sb << "SELECT * FROM (\n";
+      sql_clause_select(sb, qfields);
+      // Після полів, щоб колонки полів лишились 0..n-1
+      sb << (qfields.empty() ? "" : ", ") << record->rkey.tgtQModel->alias << ".id AS _ky_id";
+      for (size_t i = 0; i + 1 < keys.size(); ++i) {
+        sb << ", " << keys[i].pqt->alias << "." << keys[i].column << " AS " << key_column(i);
+      }
+      sql_clause_from(sb, used_tables);
+      const bool has_where = sql_clause_where_filters(sb);
+      if (recordset->seeking()) {
+        sb << (has_where ? " AND " : "\nWHERE ");
+        sql_clause_seek(sb);
+      }
+      // Попередня сторінка - перші рядки у зворотному порядку від межі
+      sql_clause_sort(sb, prev);
+      sql_clause_pager(sb);
+      if (prev) {
+        sb << "\n) AS page\nORDER BY ";
+        for (size_t i = 0; i < keys.size(); ++i) {
+          sb << (i ? ", " : "") << key_column(i) << (keys[i].desc ? " DESC" : "");
+        }
+      }
+      sb << ";";
+    });
   }
 
+  /**
+   * @brief Генерує запит даних для заданих ID.
+   * @details ID йдуть одним параметром-масивом, тож текст сталий для набору полів
+   * і може готуватись через кеш підготовлених запитів. Без сортування Recordset
+   * рядки йдуть у порядку ids.
+   * @param fields_to_load Вектор полів, які потрібно завантажити.
+   * @param ids ID записів.
+   * @return Рядок з готовим SQL-запитом.
+   */
   std::string gen_select_by_ids(const vector_prf& fields_to_load, const std::vector<std::string>& ids) {
+    params.clear();
     if (ids.empty() || fields_to_load.empty()) return "";
-    namedParams.clear();
 
     qfields_t qfields;
     qtusedmap_t used_tables;
     build_clauses_from_fields(fields_to_load, qfields, used_tables);
 
-    std::stringstream ss;
-    sql_clause_select(ss, qfields);
-    sql_clause_from(ss, used_tables);
+    bind_ids = &ids;
+    SqlShapeKey key = shape_key('b', qfields, used_tables);
+    return cached_sql(key, [&](SqlBuilder& sb) {
+      sql_clause_select(sb, qfields);
+      sql_clause_from(sb, used_tables);
+
+      const auto* mtable = record->rkey.tgtQModel;
+      sb << "\nWHERE " << mtable->alias << ".id";
+      sql_id_any(sb, ids);
+      if (recordset && !recordset->sorts.empty()) {
+        sql_clause_sort(sb);
+      } else {
+        sb << "\nORDER BY array_position(";
+        sb.ref(sb.last()) << "::int[], " << mtable->alias << ".id)";
+      }
+      sb << ";";
+    });
+  }
+
+  /**
+   * @brief Генерує запит усіх рядків за фільтрами та сортуванням, без пагінації.
+   * @details Для потокового читання (Recordset::LoadStream), коли рядки не вміщуються в сторінку.
+   * @param fields_to_load Вектор полів, які потрібно завантажити.
+   * @return Рядок з готовим SQL-запитом.
+   */
+  std::string gen_select_all(const vector_prf& fields_to_load) {
+    if (!recordset) throw std::logic_error("gen_select_all can only be called for a Recordset.");
+    params.clear();
+    if (fields_to_load.empty()) return "";
+
+    qfields_t qfields;
+    qtusedmap_t used_tables;
+    build_clauses_from_fields(fields_to_load, qfields, used_tables);
+    add_tables_from_filters(used_tables);
+    add_tables_from_sorts(used_tables);
+
+    SqlShapeKey key = shape_key('a', qfields, used_tables);
+    return cached_sql(key, [&](SqlBuilder& sb) {
+      sql_clause_select(sb, qfields);
+      sql_clause_from(sb, used_tables);
+      sql_clause_where_filters(sb);
+      sql_clause_sort(sb);
+      sb << ";";
+    });
+  }
+
+  /**
+   * @brief Генерує read-after-write запит для кількох записів однієї QModel (Record::SaveBatch).
+   * @details Першою колонкою йде id головної таблиці, щоб зіставити рядки з записами.
+   * JOIN-и тільки стандартні: "розумний" JOIN за зміненим FK цього запису
+   * не підходить іншим записам пакета, а після запису значення FK вже в БД.
+   * @param fields_to_load Поля record; у решти записів пакета - поля тих самих QField.
+   * @param ids ID записів пакета.
+   * @return Рядок з готовим SQL-запитом.
+   */
+  std::string gen_reload_by_ids(const vector_prf& fields_to_load, const std::vector<std::string>& ids) {
+    params.clear();
+    if (ids.empty() || fields_to_load.empty()) return "";
+
+    qfields_t qfields;
+    qtusedmap_t used_tables;
+    build_clauses_from_fields(fields_to_load, qfields, used_tables);
+
+    SqlBuilder sb(params);
+    sql_clause_select(sb, qfields, true);
 
     const auto* mtable = record->rkey.tgtQModel;
-    ss << "\nWHERE " << mtable->alias << ".id IN (";
-    bool first = true;
-    for (size_t i = 0; i < ids.size(); ++i) {
-      if (!first) ss << ", ";
-      first = false;
-      std::string param_name = "id_" + std::to_string(i);
-      ss << "$" << param_name;
-      namedParams[param_name] = ids[i];
-    }
-    ss << ")";
-    sql_clause_sort(ss);
-    ss << ";";
-    return ss.str();
-  }
-
-  std::vector<std::string> getOrderedParams(const std::string& sql) const {
-    std::vector<std::string> ordered_params;
-    std::string current_param_name;
-    bool in_param = false;
-
-    for (size_t i = 0; i < sql.length(); ++i) {
-      char c = sql[i];
-      if (c == '$') {
-        in_param = true;
-        current_param_name.clear();
-      } else if (in_param) {
-        if (std::isalnum(c) || c == '_') {
-          current_param_name += c;
-        } else {
-          auto it = namedParams.find(current_param_name);
-          if (it == namedParams.end()) throw std::runtime_error("Parameter not found: " + current_param_name);
-          ordered_params.push_back(it->second);
-          in_param = false;
-        }
+    smart_joins = false;
+    sql_clause_from(sb, used_tables);
+    smart_joins = true;
+
+    sb << "\nWHERE " << mtable->alias << ".id";
+    sql_id_any(sb, ids);
+    sb << ";";
+    return sb.str();
+  }
+
+  /// Параметри останнього gen_* методу в порядку $1..$n його тексту.
+  const std::vector<std::string>& getParams() const { return params; }
+
+  /// Забирає параметри останнього gen_* методу (без копіювання значень).
+  std::vector<std::string> takeParams() { return std::move(params); }
+
+private:
+  // --- Кеш форм SQL ---
+  // Спільний для всіх Recordset і сесій процесу: форма залежить лише від метаданих,
+  // полів, фільтрів, сортування та "розумних" JOIN, але не від значень параметрів.
+  struct CachedSql {
+    std::string sql;
+    std::vector<SqlBind> plan;  // джерела $1..$n
+  };
+
+  static ShardedReplacementCache<CachedSql>& shape_cache() {
+    static ShardedReplacementCache<CachedSql> cache(4096);
+    return cache;
+  }
+
+  /// Текст SQL з кешу форм; build(sb) виконується лише при промаху,
+  /// а при влучанні params заповнює план прив'язки, збережений поряд з текстом.
+  template <typename Build>
+  std::string cached_sql(const SqlShapeKey& key, Build&& build) {
+    if (auto cached = shape_cache().get(key.str())) {
+      params.reserve(cached->plan.size());
+      for (const SqlBind& bind : cached->plan) params.push_back(bind_value(bind));
+      return cached->sql;
+    }
+    CachedSql cached;
+    SqlBuilder sb(params, &cached.plan);
+    build(sb);
+    cached.sql = sb.str();
+    std::string sql = cached.sql;
+    shape_cache().put(key.str(), std::move(cached));
+    return sql;
+  }
+
+  /// Значення параметра за кроком плану - з поточного стану record/recordset.
+  std::string bind_value(const SqlBind& bind) const {
+    switch (bind.from) {
+      case SqlBind::From::join: {
+        const auto* pqt = static_cast<const QTable*>(bind.table);
+        return std::string(record->getRField(pqt->ppqt, pqt->fk_in_parent)->val);
       }
+      case SqlBind::From::filter: return filter_parsers[bind.index].value(bind.sub);
+      case SqlBind::From::seek: return recordset->seekKey[bind.index];
+      case SqlBind::From::limit: return std::to_string(recordset->pager.limit);
+      case SqlBind::From::offset: return std::to_string(recordset->pager.offset);
+      case SqlBind::From::id: return getIdFieldValue();
+      case SqlBind::From::ids: return id_array(*bind_ids);
+    }
+    throw std::logic_error("SqlGenius: unknown parameter source.");
+  }
+
+  /**
+   * @brief Ключ форми; заодно розбирає фільтри для sql_clause_where_filters().
+   * @param kind Код методу генерації.
+   * @param qfields Поля SELECT.
+   * @param used_tables Таблиці запиту, для стану "розумних" JOIN.
+   */
+  SqlShapeKey shape_key(char kind, const qfields_t& qfields, const qtusedmap_t& used_tables) {
+    SqlShapeKey key(kind);
+    key.add(static_cast<const void*>(record->rkey.tgtQModel));
+    for (const QField* qfield : qfields) key.add(static_cast<const void*>(qfield));
+
+    // "Розумний" JOIN змінює текст, тож входить у форму
+    key.add('j');
+    for (const auto& [alias, pqt] : used_tables) {
+      if (!pqt->ppqt || !smart_joins) continue;
+      RField* rfield = record->getRField(pqt->ppqt, pqt->fk_in_parent);
+      if (rfield && rfield->is_modified) key.add(static_cast<const void*>(pqt));
     }
-    if (in_param && !current_param_name.empty()) {
-      auto it = namedParams.find(current_param_name);
-      if (it == namedParams.end()) throw std::runtime_error("Parameter not found: " + current_param_name);
-      ordered_params.push_back(it->second);
+
+    filter_parsers.clear();
+    if (!recordset) return key;
+    key.add('f');
+    for (const auto& filter : recordset->filters) {
+      const auto& parser = filter_parsers.emplace_back(filter);
+      key.add(static_cast<const void*>(&filter.rfield.qfield));
+      key.add(std::string_view(parser.getShape()));
     }
-    return ordered_params;
+    key.add('s');
+    for (const auto& sort : recordset->sorts) {
+      key.add(static_cast<const void*>(&sort.rfield.qfield));
+      key.add(sort.dir == Recordset::Sort::Direction::DESC ? 'D' : 'A');
+    }
+    key.add(!recordset->seeking() ? 'O' : recordset->seek == Recordset::Seek::NEXT ? '>' : '<');
+    return key;
   }
 
-private:
   // --- Допоміжні методи ---
 
   void build_clauses_from_fields(const vector_prf& fields, qfields_t& qfields, qtusedmap_t& used_tables) {
@@ -376,6 +752,127 @@ private:
     }
   }
 
+  /// Ключ порядку Recordset: поле сортування або id головної таблиці.
+  struct OrderKey {
+    const QTable* pqt;
+    std::string column;
+    bool desc;
+    bool nullable;  // NULL можливий: поле не required або таблиця приєднана LEFT JOIN
+  };
+
+  /// Поля сортування, а за ними id - щоб порядок, а отже і межа сторінки, були однозначні.
+  std::vector<OrderKey> order_keys() const {
+    std::vector<OrderKey> keys;
+    for (const auto& s : recordset->sorts) {
+      const auto* qfield = &s.rfield.qfield;
+      const bool required = qfield->pqt->isMaster() && qfield->pf->flags.count("required");
+      keys.push_back({qfield->pqt, qfield->pf->sqlName(), s.dir == Recordset::Sort::Direction::DESC, !required});
+    }
+    // id у напрямку останнього поля: за однакових напрямків seek - одне порівняння рядків
+    keys.push_back({record->rkey.tgtQModel, "id", !keys.empty() && keys.back().desc, false});
+    return keys;
+  }
+
+  /// Умова keyset-пагінації: рядки після (NEXT) чи перед (PREV) межею recordset->seekKey.
+  /// Межа без NULL (інакше Recordset бере OFFSET), але NULL у рядках більший за будь-яке
+  /// значення (ASC - NULLS LAST, DESC - NULLS FIRST), тож для " > " по полю, що допускає NULL,
+  /// додається гілка IS NULL - інакше такі рядки випали б із наступних сторінок.
+  void sql_clause_seek(SqlBuilder& sb) {
+    const auto keys = order_keys();
+    const auto& values = recordset->seekKey;
+    if (values.size() != keys.size()) {
+      throw std::logic_error("SqlGenius: seek key does not match the Recordset sort.");
+    }
+    const bool forward = recordset->seek == Recordset::Seek::NEXT;
+    auto op = [&](const OrderKey& key) { return key.desc != forward ? " > " : " < "; };
+
+    const bool uniform =
+        std::all_of(keys.begin(), keys.end(), [&](const OrderKey& key) { return key.desc == keys.front().desc; });
+    auto nulls_after = [&](const OrderKey& key) { return key.nullable && key.desc != forward; };
+
+    if (uniform) {
+      // (k1, k2, id) > ($1, $2, $3) - Postgres бере його індексом по (k1, k2, id)
+      const bool with_nulls = std::any_of(keys.begin(), keys.end(), nulls_after);
+      sb << (with_nulls ? "((" : "(");
+      for (size_t i = 0; i < keys.size(); ++i) sb << (i ? ", " : "") << keys[i].pqt->alias << "." << keys[i].column;
+      sb << ")" << op(keys.front()) << "(";
+      const size_t first = sb.last() + 1;
+      for (size_t i = 0; i < keys.size(); ++i) {
+        if (i) sb << ", ";
+        sb.param({SqlBind::From::seek, i}, values[i]);
+      }
+      sb << ")";
+      if (!with_nulls) return;
+      // ... OR k1 IS NULL OR (k1 = $1 AND k2 IS NULL)
+      for (size_t j = 0; j < keys.size(); ++j) {
+        if (!nulls_after(keys[j])) continue;
+        sb << " OR " << (j ? "(" : "");
+        for (size_t i = 0; i < j; ++i) {
+          sb << keys[i].pqt->alias << "." << keys[i].column << " = ";
+          sb.ref(first + i) << " AND ";
+        }
+        sb << keys[j].pqt->alias << "." << keys[j].column << " IS NULL" << (j ? ")" : "");
+      }
+      sb << ")";
+      return;
+    }
+
+    // Різні напрямки: (k1 > $1 OR k1 IS NULL OR (k1 = $1 AND (k2 < $2 OR (k2 = $2 AND id > $3))))
+    for (size_t i = 0; i < keys.size(); ++i) {
+      const auto& key = keys[i];
+      sb << "(" << key.pqt->alias << "." << key.column << op(key);
+      sb.param({SqlBind::From::seek, i}, values[i]);
+      if (nulls_after(key)) sb << " OR " << key.pqt->alias << "." << key.column << " IS NULL";
+      if (i + 1 < keys.size()) {
+        sb << " OR (" << key.pqt->alias << "." << key.column << " = ";
+        sb.ref(sb.last()) << " AND ";
+      }
+    }
+    for (size_t i = 1; i < keys.size(); ++i) sb << "))";
+    sb << ")";
+  }
+
+  /// Тіло gen_insert() без RETURNING. @return false, якщо вставляти нічого.
+  bool sql_insert(SqlBuilder& sb) {
+    const std::string columns = insert_columns();
+    if (columns.empty()) return false;
+    sb << "INSERT INTO " << record->rkey.tgtQModel->pt->name << " (" << columns << ") VALUES (";
+    bool first = true;
+    for (const auto& rf : record->rfields.all()) {
+      if (!is_insert_field(rf)) continue;
+      if (!first) sb << ", ";
+      sb.param(std::string(rf.val));
+      first = false;
+    }
+    sb << ")";
+    return true;
+  }
+
+  /// Тіло gen_update() без ";". @return false, якщо змінених полів немає.
+  bool sql_update(SqlBuilder& sb) {
+    const auto* mtable = record->rkey.tgtQModel;
+    // Псевдонім - бо sql_clause_where_id() пише "master.id"
+    sb << "UPDATE " << mtable->pt->name << " AS " << mtable->alias << " SET ";
+    bool first = true;
+    for (const auto& rf : record->rfields.all()) {
+      if (rf.qfield.pqt != mtable || !rf.is_modified || rf.qfield.pf->name == "id") continue;
+      if (!first) sb << ", ";
+      first = false;
+
+      sb << rf.qfield.pf->sqlName() << " = ";
+      sb.param(std::string(rf.val));
+    }
+    if (first) return false;
+
+    sql_clause_where_id(sb);
+    return true;
+  }
+
+  /// Поле, яке INSERT записує: змінене поле головної таблиці, крім id.
+  bool is_insert_field(const RField& rf) const {
+    return rf.qfield.pqt == record->rkey.tgtQModel && rf.is_modified && rf.qfield.pf->name != "id";
+  }
+
   std::string getIdFieldValue() const {
     const auto* source_field = record->rkey.srcRField;
     if (source_field && !source_field->is_null) {
@@ -384,21 +881,27 @@ private:
     throw std::runtime_error("Database ID for the record is not available via RKey.srcRField.");
   }
 
-  void sql_clause_select(std::stringstream& ss, const qfields_t& qfields) const {
-    ss << "SELECT ";
+  /// @param with_master_id Першою колонкою додати id головної таблиці.
+  void sql_clause_select(SqlBuilder& sb, const qfields_t& qfields, bool with_master_id = false) const {
+    sb << "SELECT ";
     bool first_field = true;
+    if (with_master_id) {
+      sb << record->rkey.tgtQModel->alias << ".id";
+      first_field = false;
+    }
     for (const auto qfield : qfields) {
-      if (!first_field) ss << ", ";
-      ss << qfield->pqt->alias << "." << qfield->pf->sqlName() << " AS " << qfield->pqt->alias << "_"
+      if (!first_field) sb << ", ";
+      sb << qfield->pqt->alias << "." << qfield->pf->sqlName() << " AS " << qfield->pqt->alias << "_"
          << qfield->pf->sqlName();
       first_field = false;
     }
   }
 
-  void sql_clause_from(std::stringstream& ss, qtusedmap_t& used_tables) {
+  /// @param source Джерело рядків головної таблиці замість неї самої, напр. CTE "saved".
+  void sql_clause_from(SqlBuilder& sb, qtusedmap_t& used_tables, const std::string& source = "") {
     const auto& rkey = record->rkey;
     const auto* mtable = rkey.tgtQModel;
-    ss << "\nFROM " << mtable->pt->name << " AS " << mtable->alias;
+    sb << "\nFROM " << (source.empty() ? mtable->pt->name : source) << " AS " << mtable->alias;
     used_tables.erase(mtable->alias);
 
     std::function<void(const QTable*)> build_joins;
@@ -407,19 +910,18 @@ private:
       if (!pqt->ppqt->isMaster()) build_joins(pqt->ppqt);
       if (used_tables.count(pqt->alias) == 0) return;
 
-      ss << "\nLEFT JOIN " << pqt->pt->name << " AS " << pqt->alias << " ON ";
+      sb << "\nLEFT JOIN " << pqt->pt->name << " AS " << pqt->alias << " ON ";
 
       RField* rfield = record->getRField(pqt->ppqt, pqt->fk_in_parent);
 
-      ss << pqt->alias << ".id";
-      if (rfield && rfield->is_modified) {
+      sb << pqt->alias << ".id";
+      if (smart_joins && rfield && rfield->is_modified) {
         // "Розумний" JOIN
-        std::string param_name = "smart_join_" + pqt->alias;
-        ss << " = $" << param_name;
-        namedParams[param_name] = std::string(rfield->val);
+        sb << " = ";
+        sb.param({SqlBind::From::join, 0, 0, pqt}, std::string(rfield->val));
       } else {
         // Стандартний JOIN
-        ss << " = " << pqt->ppqt->alias << "." << pqt->fk_in_parent->sqlName();
+        sb << " = " << pqt->ppqt->alias << "." << pqt->fk_in_parent->sqlName();
       }
 
       used_tables.erase(pqt->alias);
@@ -430,17 +932,41 @@ private:
     }
   }
 
-  void sql_clause_where_id(std::stringstream& ss) const {
+  /// Пише " = ANY($n::int[])" з одним параметром-масивом ids замість списку IN ($1, ..., $n).
+  static void sql_id_any(SqlBuilder& sb, const std::vector<std::string>& ids) {
+    sb << " = ANY(";
+    sb.param({SqlBind::From::ids}, id_array(ids)) << "::int[])";
+  }
+
+  /// Літерал масиву Postgres; лапки - щоб кома чи дужка в значенні не зламали розбір.
+  static std::string id_array(const std::vector<std::string>& ids) {
+    std::string array = "{";
+    for (size_t i = 0; i < ids.size(); ++i) {
+      if (i) array += ',';
+      array += '"';
+      for (char c : ids[i]) {
+        if (c == '"' || c == '\\') array += '\\';
+        array += c;
+      }
+      array += '"';
+    }
+    array += '}';
+    return array;
+  }
+
+  void sql_clause_where_id(SqlBuilder& sb) const {
     const auto& rkey = record->rkey;
     const auto* mtable = rkey.tgtQModel;
-    ss << "\nWHERE " << mtable->alias << ".id = $id";
+    sb << "\nWHERE " << mtable->alias << ".id = ";
+    sb.param({SqlBind::From::id}, getIdFieldValue());
   }
 
   // =================================================================
   // <<< НОВА РЕАЛІЗАЦІЯ >>>
   // =================================================================
-  void sql_clause_where_filters(std::stringstream& ss) {
-    if (!recordset) return;
+  /// @return true, якщо записано WHERE.
+  bool sql_clause_where_filters(SqlBuilder& sb) {
+    if (!recordset) return false;
 
     /*
      * =================================================================
@@ -448,60 +974,59 @@ private:
      * =================================================================
      */
 
-    if (recordset->filters.empty()) {
-      return;
+    if (filter_parsers.empty()) {
+      return false;
     }
 
-    ss << "\nWHERE ";
+    sb << "\nWHERE ";
     bool first_filter_group = true;
 
-    for (const auto& filter : recordset->filters) {
+    // Парсери створені в shape_key(), вся логіка розбору інкапсульована в них.
+    for (size_t i = 0; i < filter_parsers.size(); ++i) {
       if (!first_filter_group) {
-        ss << " AND ";
+        sb << " AND ";
       }
 
-      // Створюємо парсер для кожного фільтра.
-      // Вся логіка розбору інкапсульована в ньому.
-      FilterParser parser(filter);
-
-      // Додаємо згенерований SQL-блок
-      ss << parser.getSql();
-
-      // Копіюємо згенеровані парсером параметри до загальної мапи
-      const auto& new_params = parser.getParams();
-      namedParams.insert(new_params.begin(), new_params.end());
+      // Додаємо SQL-блок разом з його параметрами
+      filter_parsers[i].write(sb, i);
 
       first_filter_group = false;
     }
+    return true;
   }
 
-  void sql_clause_sort(std::stringstream& ss) const {
-    if (!recordset || recordset->sorts.empty()) {
+  /// @param reverse Зворотний порядок - для попередньої сторінки keyset.
+  void sql_clause_sort(SqlBuilder& sb, bool reverse = false) const {
+    if (!recordset) {
       return;
     }
-    ss << "\nORDER BY ";
+    sb << "\nORDER BY ";
     bool first = true;
-    for (const auto& s : recordset->sorts) {
-      if (!first) ss << ", ";
+    for (const auto& key : order_keys()) {
+      if (!first) sb << ", ";
       first = false;
-      const auto* qfield = &s.rfield.qfield;
-      ss << qfield->pqt->alias << "." << qfield->pf->sqlName();
-      if (s.dir == Recordset::Sort::Direction::DESC) ss << " DESC";
+      sb << key.pqt->alias << "." << key.column;
+      if (key.desc != reverse) sb << " DESC";
     }
   }
 
-  void sql_clause_pager(std::stringstream& ss) {
+  void sql_clause_pager(SqlBuilder& sb) {
     if (!recordset) return;
-    ss << "\nLIMIT $pg_limit OFFSET $pg_offset";
     const auto& pager = recordset->pager;
-    namedParams["pg_limit"] = std::to_string(pager.limit);
-    namedParams["pg_offset"] = std::to_string(pager.offset);
+    sb << "\nLIMIT ";
+    sb.param({SqlBind::From::limit}, std::to_string(pager.limit));
+    if (recordset->seeking()) return;  // Межу задає sql_clause_seek()
+    sb << " OFFSET ";
+    sb.param({SqlBind::From::offset}, std::to_string(pager.offset));
   }
 
   // --- Члени класу ---
   Record* record;
   Recordset* recordset;
-  std::map<std::string, std::string> namedParams;
+  std::vector<std::string> params;          // значення $1..$n останнього gen_* методу
+  std::vector<FilterParser> filter_parsers;  // фільтри recordset, розібрані в shape_key()
+  const std::vector<std::string>* bind_ids = nullptr;  // ids останнього gen_select_by_ids() для плану
+  bool smart_joins = true;  // false - sql_clause_from() будує лише стандартні JOIN
 };
 
 }  // namespace ky
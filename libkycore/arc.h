@@ -1,90 +1,241 @@
+#pragma once
+
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <unordered_map>
-#include <list>
-#include <set>
 #include <optional>
 #include <algorithm>
+#include <cstdint>
 #include <vector>
 #include <mutex>
 #include <thread>
 #include <memory>
+#include <type_traits>
+#include <functional>
 
-template <typename T>
+// Політика вибору запису для витіснення
+enum class ArcEvictionPolicy {
+    Recency,   // хвіст LRU або найменший useCount в LFU, без урахування вартості
+    CostAware  // найменша очікувана вартість промаху: useCount * cost (див. doc/arc_on_steroid.md)
+};
+
+// Політики AdaptiveReplacementCache (параметр шаблону Policy)
+struct ArcSoftLimit {};  // softLimit за hit rate + перехід у LFU після lfuThreshold звернень
+struct ArcTrue {};       // ARC (Megiddo, Modha): T1/T2, тіньові B1/B2 та адаптивна ціль p
+
+// Ключ кешу з хешем, обчисленим один раз при створенні. Мапа кешу бере хеш звідси,
+// тож пошук не хешує рядок повторно; ShardedReplacementCache тим самим хешем вибирає шард.
+// Ключ лише дивиться на рядок: для пошуку його треба тримати до кінця виклику.
+struct ArcKey {
+    std::string_view view;
+    size_t hash;
+
+    template <typename S>
+        requires std::is_convertible_v<const S&, std::string_view>
+    ArcKey(const S& key) : view(key), hash(std::hash<std::string_view>{}(view)) {}
+    ArcKey(std::string_view view, size_t hash) : view(view), hash(hash) {}
+
+    bool operator==(const ArcKey& other) const { return hash == other.hash && view == other.view; }
+};
+
+struct ArcKeyHash {
+    size_t operator()(const ArcKey& key) const noexcept { return key.hash; }
+};
+
+// Інтрузивний двозв'язний список вузлів з полями prev/next; head - найсвіжіший
+template <typename Node>
+struct ArcList {
+    Node* head = nullptr;
+    Node* tail = nullptr;
+    size_t size = 0;
+
+    void push_front(Node* node) {
+        node->prev = nullptr;
+        node->next = head;
+        if (head) head->prev = node;
+        head = node;
+        if (!tail) tail = node;
+        ++size;
+    }
+
+    void unlink(Node* node) {
+        (node->prev ? node->prev->next : head) = node->next;
+        (node->next ? node->next->prev : tail) = node->prev;
+        node->prev = node->next = nullptr;
+        --size;
+    }
+};
+
+// Пошук у кеші (get/contains) не виділяє пам'ять: ключ мапи - ArcKey на єдину копію рядка
+// у вузлі разом з хешем, а LRU-список і LFU-купа інтрузивні, тож просування запису лише переставляє вказівники.
+// Пам'ять виділяє тільки put() - під новий вузол.
+template <typename T, typename Policy = ArcSoftLimit>
 class AdaptiveReplacementCache {
+    static_assert(std::is_same_v<Policy, ArcSoftLimit>, "Unknown AdaptiveReplacementCache policy");
+
 private:
+    // Вузол володіє ключем; мапа, LRU і LFU посилаються на вузол
     struct CacheEntry {
+        std::string key;
+        size_t hash;  // ArcKey::hash ключа: видалення з мапи без повторного хешування
         T value;
-        int useCount;
-        bool is_in_lfu;
+        int useCount = 1;
+        double cost = 1.0;  // ціна повторного створення значення після витіснення
+        bool is_in_lfu = false;
+
+        // LRU: позиція в ArcList
+        CacheEntry* prev = nullptr;
+        CacheEntry* next = nullptr;
 
-        typename std::list<std::string>::iterator lru_it;
-        typename std::set<std::pair<int, std::string>>::iterator lfu_it;
+        // LFU: позиція в lfu_heap; при рівних priority() першим іде давніше використаний (lfu_seq)
+        size_t lfu_index = 0;
+        double lfu_priority = 0;
+        uint64_t lfu_seq = 0;
     };
 
     mutable std::mutex cache_mutex;
-    std::unordered_map<std::string, CacheEntry> cache;
-    std::list<std::string> lru_keys;
-    std::set<std::pair<int, std::string>> lfu_keys;
+    std::unordered_map<ArcKey, std::unique_ptr<CacheEntry>, ArcKeyHash> cache;
+    ArcList<CacheEntry> lru;
+    std::vector<CacheEntry*> lfu_heap;  // мін-купа за (lfu_priority, lfu_seq)
+    uint64_t lfu_counter = 0;
 
     // --- Конфігурація ---
     int softLimit;
     int hardLimit;
     int lfuThreshold;
     const int minLimit;
+    const ArcEvictionPolicy policy;
+    // CostAware: скільки записів з хвоста LRU порівнюються за вартістю.
+    // Обмеження зберігає рецентність: дорогий, але давно не потрібний запис все одно піде.
+    static constexpr int costWindow = 8;
 
     // --- Статистика ---
     int total_accesses{0};
     int hits{0};
-    
+
     // --- Приватні методи (викликаються під блокуванням) ---
 
+    // --- LFU ---
+    static bool lfu_less(const CacheEntry* a, const CacheEntry* b) {
+        return a->lfu_priority != b->lfu_priority ? a->lfu_priority < b->lfu_priority : a->lfu_seq < b->lfu_seq;
+    }
+
+    void lfu_place(size_t i, CacheEntry* entry) {
+        lfu_heap[i] = entry;
+        entry->lfu_index = i;
+    }
+
+    void lfu_sift_up(size_t i) {
+        CacheEntry* entry = lfu_heap[i];
+        while (i > 0) {
+            size_t parent = (i - 1) / 2;
+            if (!lfu_less(entry, lfu_heap[parent])) break;
+            lfu_place(i, lfu_heap[parent]);
+            i = parent;
+        }
+        lfu_place(i, entry);
+    }
+
+    void lfu_sift_down(size_t i) {
+        CacheEntry* entry = lfu_heap[i];
+        const size_t n = lfu_heap.size();
+        while (true) {
+            size_t child = 2 * i + 1;
+            if (child >= n) break;
+            if (child + 1 < n && lfu_less(lfu_heap[child + 1], lfu_heap[child])) ++child;
+            if (!lfu_less(lfu_heap[child], entry)) break;
+            lfu_place(i, lfu_heap[child]);
+            i = child;
+        }
+        lfu_place(i, entry);
+    }
+
+    // Оновлює позицію запису після зміни useCount
+    void lfu_touch(CacheEntry* entry) {
+        entry->lfu_priority = priority(*entry);
+        entry->lfu_seq = ++lfu_counter;
+        lfu_sift_down(entry->lfu_index);  // priority і seq лише зростають
+    }
+
+    void lfu_remove(CacheEntry* entry) {
+        size_t i = entry->lfu_index;
+        CacheEntry* last = lfu_heap.back();
+        lfu_heap.pop_back();
+        if (last == entry) return;
+        lfu_place(i, last);
+        lfu_sift_up(i);
+        lfu_sift_down(last->lfu_index);
+    }
+
+    // Цінність запису для кешу: чим менша, тим дешевше його втратити
+    double priority(const CacheEntry& entry) const {
+        return policy == ArcEvictionPolicy::CostAware ? entry.useCount * entry.cost : entry.useCount;
+    }
+
     // Повністю видаляє запис з усіх структур
-    void remove_entry(typename std::unordered_map<std::string, CacheEntry>::iterator it) {
-        CacheEntry& entry = it->second;
-        if (entry.is_in_lfu) {
-            lfu_keys.erase(entry.lfu_it);
+    void remove_entry(CacheEntry* entry) {
+        if (entry->is_in_lfu) {
+            lfu_remove(entry);
         } else {
-            lru_keys.erase(entry.lru_it);
+            lru.unlink(entry);
         }
-        cache.erase(it);
+        cache.erase(cache.find(ArcKey(entry->key, entry->hash)));
     }
 
     void evict() {
-        if (lfu_keys.size() > lru_keys.size() && !lfu_keys.empty()) {
+        if (policy == ArcEvictionPolicy::CostAware) {
+            // Порівнюємо кандидатів обох частин і витісняємо дешевшого
+            if (lfu_heap.empty()) {
+                evict_from_lru();
+            } else if (!lru.tail || lfu_heap.front()->lfu_priority < priority(*lru_candidate())) {
+                evict_from_lfu();
+            } else {
+                evict_from_lru();
+            }
+            return;
+        }
+        if (lfu_heap.size() > lru.size && !lfu_heap.empty()) {
             evict_from_lfu();
         } else {
             evict_from_lru();
         }
     }
 
+    // Recency: хвіст LRU. CostAware: найдешевший з costWindow останніх, при рівності - старіший.
+    CacheEntry* lru_candidate() const {
+        CacheEntry* victim = lru.tail;
+        if (policy != ArcEvictionPolicy::CostAware || !victim) return victim;
+        double victim_priority = priority(*victim);
+        CacheEntry* entry = victim->prev;
+        for (int i = 1; i < costWindow && entry; ++i, entry = entry->prev) {
+            double p = priority(*entry);
+            if (p < victim_priority) {
+                victim = entry;
+                victim_priority = p;
+            }
+        }
+        return victim;
+    }
+
     void evict_from_lru() {
-        if (lru_keys.empty()) return;
-        const std::string& key_to_evict = lru_keys.back();
-        // Спочатку знаходимо ітератор в мапі, щоб потім передати його в remove_entry
-        auto it = cache.find(key_to_evict);
-        if (it != cache.end()) {
-            remove_entry(it);
+        if (CacheEntry* victim = lru_candidate()) {
+            remove_entry(victim);
         }
     }
 
     void evict_from_lfu() {
-        if (lfu_keys.empty()) return;
-        auto it_lfu = lfu_keys.begin();
-        const std::string& key_to_evict = it_lfu->second;
-        // Спочатку знаходимо ітератор в мапі, щоб потім передати його в remove_entry
-        auto it_cache = cache.find(key_to_evict);
-        if (it_cache != cache.end()) {
-            remove_entry(it_cache);
-        }
+        if (lfu_heap.empty()) return;
+        remove_entry(lfu_heap.front());
     }
 
-    void move_to_lfu(typename std::unordered_map<std::string, CacheEntry>::iterator cache_it) {
-        const std::string& key = cache_it->first;
-        CacheEntry& entry = cache_it->second;
-        lru_keys.erase(entry.lru_it);
-        entry.lfu_it = lfu_keys.insert({entry.useCount, key}).first;
-        entry.is_in_lfu = true;
+    void move_to_lfu(CacheEntry* entry) {
+        lru.unlink(entry);
+        entry->is_in_lfu = true;
+        entry->lfu_priority = priority(*entry);
+        entry->lfu_seq = ++lfu_counter;
+        lfu_heap.push_back(entry);
+        lfu_sift_up(lfu_heap.size() - 1);
     }
 
     void trim() {
@@ -116,47 +267,73 @@ private:
     }
 
 public:
-    explicit AdaptiveReplacementCache(int hard_limit)
-        : hardLimit(hard_limit), 
-          minLimit(std::max(1, hard_limit / 10))
+    explicit AdaptiveReplacementCache(int hard_limit,
+                                      ArcEvictionPolicy policy = ArcEvictionPolicy::CostAware)
+        : hardLimit(hard_limit),
+          minLimit(std::max(1, hard_limit / 10)),
+          policy(policy)
     {
         softLimit = minLimit;
         lfuThreshold = std::max(2, hard_limit / 20);
+        // Кеш не перевищує hardLimit, тож ні мапа, ні купа далі не перерозподіляються
+        cache.reserve(hard_limit + 1);
+        lfu_heap.reserve(hard_limit + 1);
     }
 
+    AdaptiveReplacementCache(const AdaptiveReplacementCache&) = delete;
+    AdaptiveReplacementCache& operator=(const AdaptiveReplacementCache&) = delete;
+
     // Змінено для прийняття r-value reference і повернення T*
-    T* put(const std::string& key, T&& value) {
+    // cost - ціна повторного створення value (напр. час PQprepare); має сенс лише відносно
+    // інших записів і враховується тільки політикою CostAware.
+    T* put(const ArcKey& key, T&& value, double cost = 1.0) {
         std::lock_guard<std::mutex> lock(cache_mutex);
 
         auto it = cache.find(key);
         if (it != cache.end()) {
             // Повністю видаляємо старий запис перед вставкою нового.
             // Це гарантує коректне знищення RAII об'єкта і скидання метаданих.
-            remove_entry(it);
+            remove_entry(it->second.get());
         }
 
         if (cache.size() >= softLimit) {
             evict();
         }
-        
-        CacheEntry new_entry;
-        new_entry.value = std::move(value); // Переміщуємо, а не копіюємо
-        new_entry.useCount = 1;
-        new_entry.is_in_lfu = false;
-        
-        lru_keys.push_front(key);
-        new_entry.lru_it = lru_keys.begin();
-        
-        // emplace повертає пару, перший елемент якої - ітератор на вставлений елемент
-        auto emplace_result = cache.emplace(key, std::move(new_entry));
+
+        // Переміщуємо, а не копіюємо
+        std::unique_ptr<CacheEntry> new_entry(new CacheEntry{std::string(key.view), key.hash, std::move(value)});
+        new_entry->cost = cost;
+        CacheEntry* entry = new_entry.get();
+
+        // Ключ мапи дивиться на рядок у вузлі, тож живе рівно стільки, скільки запис
+        cache.emplace(ArcKey(entry->key, entry->hash), std::move(new_entry));
+        lru.push_front(entry);
         // Повертаємо вказівник на щойно вставлене значення
-        return &emplace_result.first->second.value;
+        return &entry->value;
+    }
+
+    // Перевірка наявності без впливу на статистику та порядок витіснення
+    bool contains(const ArcKey& key) const {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        return cache.count(key) > 0;
     }
 
     // Змінено для повернення вказівника
-    T* get(const std::string& key) {
+    T* get(const ArcKey& key) {
         std::lock_guard<std::mutex> lock(cache_mutex);
+        return get_unlocked(key);
+    }
 
+    // Копія значення, зроблена під блокуванням. Для кешу, спільного між потоками:
+    // вказівник з get() може пережити запис, якщо його витіснить інший потік.
+    std::optional<T> get_copy(const ArcKey& key) {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        T* value = get_unlocked(key);
+        return value ? std::optional<T>(*value) : std::nullopt;
+    }
+
+private:
+    T* get_unlocked(const ArcKey& key) {
         total_accesses++;
         int adjustment_interval = softLimit * 10;
         if (total_accesses >= adjustment_interval && adjustment_interval > 0) {
@@ -167,20 +344,279 @@ public:
             return nullptr; // Повертаємо nullptr у разі промаху
         }
         hits++;
-        CacheEntry& entry = it->second;
-        entry.useCount++;
-        if (entry.is_in_lfu) {
-            lfu_keys.erase(entry.lfu_it);
-            entry.lfu_it = lfu_keys.insert({entry.useCount, key}).first;
+        CacheEntry* entry = it->second.get();
+        entry->useCount++;
+        if (entry->is_in_lfu) {
+            lfu_touch(entry);
         } else {
-            lru_keys.erase(entry.lru_it);
-            lru_keys.push_front(key);
-            entry.lru_it = lru_keys.begin();
-            if (entry.useCount > lfuThreshold) {
-                move_to_lfu(it);
+            lru.unlink(entry);
+            lru.push_front(entry);
+            if (entry->useCount > lfuThreshold) {
+                move_to_lfu(entry);
             }
         }
-        return &entry.value; // Повертаємо вказівник на значення
+        return &entry->value; // Повертаємо вказівник на значення
     }
 };
 
+// ARC у класичному вигляді (Megiddo, Modha; ZFS):
+//  T1 - записи, до яких звертались один раз, T2 - двічі й більше;
+//  B1/B2 - тіні (лише ключі) нещодавно витіснених з T1/T2.
+// Повторний запит тіні з B1 збільшує ціль p (частку T1), з B2 - зменшує.
+// Сканування (звіти, що виконуються один раз) проходить через T1 і не витісняє гарячі записи з T2.
+// Тіні живуть у тій самій мапі, що й записи: значення звільняється, вузол з ключем лишається.
+template <typename T>
+class AdaptiveReplacementCache<T, ArcTrue> {
+private:
+    enum class Where : uint8_t { T1, T2, B1, B2 };
+
+    struct CacheEntry {
+        std::string key;
+        size_t hash;
+        std::optional<T> value;  // nullopt - тінь у B1/B2
+        double cost = 1.0;
+        Where where = Where::T1;
+        int pins = 0;  // > 0 - значення не витісняється (pin/unpin)
+
+        CacheEntry* prev = nullptr;
+        CacheEntry* next = nullptr;
+    };
+
+    mutable std::mutex cache_mutex;
+    std::unordered_map<ArcKey, std::unique_ptr<CacheEntry>, ArcKeyHash> cache;  // записи і тіні
+    ArcList<CacheEntry> t1, t2, b1, b2;
+
+    // --- Конфігурація ---
+    const size_t capacity;  // c: записів зі значеннями не більше c, тіней - ще не більше c
+    size_t p = 0;           // адаптивна ціль розміру T1
+    const ArcEvictionPolicy policy;
+    static constexpr int costWindow = 8;
+
+    // --- Приватні методи (викликаються під блокуванням) ---
+
+    ArcList<CacheEntry>& list_of(Where where) {
+        switch (where) {
+        case Where::T1: return t1;
+        case Where::T2: return t2;
+        case Where::B1: return b1;
+        default: return b2;
+        }
+    }
+
+    void move_to(CacheEntry* entry, Where where) {
+        list_of(entry->where).unlink(entry);
+        entry->where = where;
+        list_of(where).push_front(entry);
+    }
+
+    // Хвіст списку без закріплених записів; для CostAware - найдешевший з costWindow останніх.
+    // nullptr - усі записи списку закріплені.
+    CacheEntry* victim_of(const ArcList<CacheEntry>& list) const {
+        CacheEntry* victim = list.tail;
+        while (victim && victim->pins > 0) victim = victim->prev;
+        if (policy != ArcEvictionPolicy::CostAware || !victim) return victim;
+        CacheEntry* entry = victim->prev;
+        for (int i = 1; i < costWindow && entry; ++i, entry = entry->prev) {
+            if (entry->pins == 0 && entry->cost < victim->cost) victim = entry;
+        }
+        return victim;
+    }
+
+    // REPLACE з ARC: переводить запис з T1 або T2 у відповідну тінь.
+    // Якщо у списку, який обрав ARC, все закріплено - береться запис з іншого;
+    // якщо закріплено все, кеш тимчасово перевищує capacity.
+    void replace(bool hit_in_b2) {
+        const bool from_t1 = t1.size > 0 && (t1.size > p || (hit_in_b2 && t1.size == p) || t2.size == 0);
+        CacheEntry* victim = victim_of(from_t1 ? t1 : t2);
+        if (!victim) victim = victim_of(from_t1 ? t2 : t1);
+        if (!victim) return;
+        const Where ghost = victim->where == Where::T1 ? Where::B1 : Where::B2;
+        victim->value.reset();  // RAII-значення знищується тут, ключ лишається тінню
+        move_to(victim, ghost);
+    }
+
+    void erase_entry(CacheEntry* entry) {
+        list_of(entry->where).unlink(entry);
+        cache.erase(cache.find(ArcKey(entry->key, entry->hash)));
+    }
+
+    size_t resident() const { return t1.size + t2.size; }
+
+public:
+    explicit AdaptiveReplacementCache(int hard_limit,
+                                      ArcEvictionPolicy policy = ArcEvictionPolicy::Recency)
+        : capacity(std::max(1, hard_limit)),
+          policy(policy)
+    {
+        cache.reserve(2 * capacity + 1);
+    }
+
+    AdaptiveReplacementCache(const AdaptiveReplacementCache&) = delete;
+    AdaptiveReplacementCache& operator=(const AdaptiveReplacementCache&) = delete;
+
+    // Виклик після промаху get(): тут же відбувається адаптація p за тінями.
+    // cost враховується лише політикою CostAware при виборі запису з хвоста T1/T2.
+    T* put(const ArcKey& key, T&& value, double cost = 1.0) {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+
+        auto it = cache.find(key);
+        CacheEntry* entry = it != cache.end() ? it->second.get() : nullptr;
+
+        if (entry && entry->value) {
+            // Заміна значення наявного запису - це звернення до нього
+            entry->value.reset();
+            entry->value.emplace(std::move(value));
+            entry->cost = cost;
+            move_to(entry, Where::T2);
+            return &*entry->value;
+        }
+
+        if (entry) {
+            const bool in_b2 = entry->where == Where::B2;
+            if (in_b2) {
+                p -= std::min(p, std::max<size_t>(1, b1.size / b2.size));
+            } else {
+                p = std::min(capacity, p + std::max<size_t>(1, b2.size / b1.size));
+            }
+            if (resident() >= capacity) replace(in_b2);
+            entry->value.emplace(std::move(value));
+            entry->cost = cost;
+            move_to(entry, Where::T2);
+            return &*entry->value;
+        }
+
+        // Зовсім новий ключ
+        if (t1.size + b1.size >= capacity) {
+            if (t1.size < capacity) {
+                erase_entry(b1.tail);
+                if (resident() >= capacity) replace(false);
+            } else if (CacheEntry* victim = victim_of(t1)) {
+                erase_entry(victim);
+            } else {
+                replace(false);
+            }
+        } else if (t1.size + t2.size + b1.size + b2.size >= capacity) {
+            if (t1.size + t2.size + b1.size + b2.size >= 2 * capacity) erase_entry(b2.tail);
+            if (resident() >= capacity) replace(false);
+        }
+
+        std::unique_ptr<CacheEntry> new_entry(new CacheEntry{std::string(key.view), key.hash, std::nullopt});
+        new_entry->value.emplace(std::move(value));
+        new_entry->cost = cost;
+        entry = new_entry.get();
+        cache.emplace(ArcKey(entry->key, entry->hash), std::move(new_entry));
+        t1.push_front(entry);
+        return &*entry->value;
+    }
+
+    // Перевірка наявності значення (не тіні) без впливу на порядок витіснення
+    bool contains(const ArcKey& key) const {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto it = cache.find(key);
+        return it != cache.end() && it->second->value.has_value();
+    }
+
+    T* get(const ArcKey& key) {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        return get_unlocked(key);
+    }
+
+    // Копія значення, зроблена під блокуванням (див. AdaptiveReplacementCache::get_copy)
+    std::optional<T> get_copy(const ArcKey& key) {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        T* value = get_unlocked(key);
+        return value ? std::optional<T>(*value) : std::nullopt;
+    }
+
+    // Закріплює значення: поки pins > 0, put() інших ключів його не витісняє,
+    // тож вказівник з get()/put() лишається дійсним. Кожному pin() - свій unpin().
+    // false - значення за ключем немає.
+    bool pin(const ArcKey& key) {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto it = cache.find(key);
+        if (it == cache.end() || !it->second->value) return false;
+        ++it->second->pins;
+        return true;
+    }
+
+    void unpin(const ArcKey& key) {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto it = cache.find(key);
+        if (it != cache.end() && it->second->pins > 0) --it->second->pins;
+    }
+
+    // Знищує всі значення і тіні (напр. до закриття з'єднання, від якого вони залежать)
+    void clear() {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        t1 = {};
+        t2 = {};
+        b1 = {};
+        b2 = {};
+        p = 0;
+        cache.clear();
+    }
+
+private:
+    T* get_unlocked(const ArcKey& key) {
+        auto it = cache.find(key);
+        if (it == cache.end() || !it->second->value) {
+            return nullptr;  // Промах; для тіні адаптація буде в put()
+        }
+        CacheEntry* entry = it->second.get();
+        move_to(entry, Where::T2);
+        return &*entry->value;
+    }
+};
+
+// Кеш, спільний для всіх сесій процесу (згенерований SQL, результати довідників).
+// Ключі розподілено за хешем між незалежними шардами зі своїм м'ютексом, тож потоки
+// блокують один одного лише при зверненні до того самого шарду.
+// Значення віддаються як shared_ptr: запис може витіснити інший потік, а handle
+// лишається дійсним, поки його тримають.
+template <typename T, typename Policy = ArcTrue>
+class ShardedReplacementCache {
+public:
+    using Handle = std::shared_ptr<const T>;
+
+    // hard_limit - на весь кеш, ділиться порівну між шардами
+    explicit ShardedReplacementCache(int hard_limit, size_t shard_count = 16,
+                                     ArcEvictionPolicy policy = ArcEvictionPolicy::Recency)
+        : shard_count(std::max<size_t>(1, shard_count))
+    {
+        const int per_shard = std::max(1, hard_limit / static_cast<int>(this->shard_count));
+        shards.reserve(this->shard_count);
+        for (size_t i = 0; i < this->shard_count; ++i) {
+            shards.push_back(std::make_unique<Shard>(per_shard, policy));
+        }
+    }
+
+    Handle get(const ArcKey& key) {
+        return shard_of(key).cache.get_copy(key).value_or(nullptr);
+    }
+
+    Handle put(const ArcKey& key, T&& value, double cost = 1.0) {
+        Handle handle = std::make_shared<const T>(std::move(value));
+        Handle copy = handle;
+        shard_of(key).cache.put(key, std::move(copy), cost);
+        return handle;
+    }
+
+    bool contains(const ArcKey& key) const {
+        return shard_of(key).cache.contains(key);
+    }
+
+private:
+    // Окремий рядок кешу на шард, щоб м'ютекси сусідніх шардів не ділили cache line
+    struct alignas(64) Shard {
+        AdaptiveReplacementCache<Handle, Policy> cache;
+        Shard(int hard_limit, ArcEvictionPolicy policy) : cache(hard_limit, policy) {}
+    };
+
+    // Хеш ключа вже обчислений - шард і мапа шарду беруть той самий
+    Shard& shard_of(const ArcKey& key) const {
+        return *shards[key.hash % shard_count];
+    }
+
+    const size_t shard_count;
+    std::vector<std::unique_ptr<Shard>> shards;
+};
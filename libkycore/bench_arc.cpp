@@ -0,0 +1,303 @@
+// Бенчмарки AdaptiveReplacementCache.
+//  trace - промахи і їх сумарна вартість для політик Recency та CostAware на трасі запитів.
+//  get/put - пропускна здатність і виділення пам'яті на операцію в порівнянні з кешем до
+//            інтрузивних вузлів (ключ у мапі, std::list та std::set).
+//  threads - ShardedReplacementCache проти того самого кешу за одним м'ютексом, 1..32 потоки.
+// Траса: ./bench_arc trace.tsv, рядок "вартість<TAB>ключ" (вартість - напр. час PQprepare, мкс);
+// без аргументу - синтетична траса з фіксованим зерном.
+#include "arc.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <new>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+// Виділення пам'яті потоком, що міряє
+thread_local size_t allocations = 0;
+
+void* operator new(size_t size) {
+    ++allocations;
+    if (void* p = std::malloc(size)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+struct TraceEntry {
+    std::string key;
+    double cost;
+};
+
+// Суміш, під яку пишеться CostAware: багато дешевих CRUD з популярністю за Zipf,
+// рідші звіти з дорогими JOIN і періодичні сканування одноразовими запитами.
+std::vector<TraceEntry> synthetic_trace(size_t length) {
+    std::mt19937 rng(42);
+    const size_t crud_count = 400, report_count = 40;
+
+    std::vector<TraceEntry> crud, reports;
+    std::uniform_real_distribution<double> crud_cost(50, 200), report_cost(2000, 20000);
+    for (size_t i = 0; i < crud_count; ++i) {
+        crud.push_back({"SELECT * FROM t" + std::to_string(i % 37) + " WHERE id = $1 /* " + std::to_string(i) + " */",
+                        crud_cost(rng)});
+    }
+    for (size_t i = 0; i < report_count; ++i) {
+        std::string sql = "SELECT ... FROM report" + std::to_string(i);
+        for (int j = 0; j < 12; ++j) sql += " JOIN t" + std::to_string(j) + " ON ...";
+        reports.push_back({std::move(sql), report_cost(rng)});
+    }
+    std::vector<double> weights;
+    for (size_t i = 0; i < crud_count; ++i) weights.push_back(1.0 / (i + 1));
+    std::discrete_distribution<size_t> zipf(weights.begin(), weights.end());
+    std::uniform_int_distribution<size_t> any_report(0, report_count - 1);
+    std::bernoulli_distribution is_report(0.1);
+
+    std::vector<TraceEntry> trace;
+    trace.reserve(length);
+    size_t adhoc = 0;
+    while (trace.size() < length) {
+        if (trace.size() % 5000 == 4999) {
+            for (int i = 0; i < 300; ++i) trace.push_back({"SELECT /* ad hoc " + std::to_string(adhoc++) + " */", 50});
+            continue;
+        }
+        trace.push_back(is_report(rng) ? reports[any_report(rng)] : crud[zipf(rng)]);
+    }
+    return trace;
+}
+
+std::vector<TraceEntry> load_trace(const char* path) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error(std::string("cannot open ") + path);
+    std::vector<TraceEntry> trace;
+    std::string line;
+    while (std::getline(in, line)) {
+        auto tab = line.find('\t');
+        if (tab == std::string::npos) continue;
+        trace.push_back({line.substr(tab + 1), std::stod(line.substr(0, tab))});
+    }
+    return trace;
+}
+
+// Як PgConn: get(), при промаху - "підготувати" і put() з вартістю
+template <typename Policy>
+void replay(const char* name, ArcEvictionPolicy policy, int capacity, const std::vector<TraceEntry>& trace) {
+    AdaptiveReplacementCache<int, Policy> cache(capacity, policy);
+    size_t misses = 0;
+    double miss_cost = 0;
+    for (const auto& e : trace) {
+        if (cache.get(e.key)) continue;
+        ++misses;
+        miss_cost += e.cost;
+        cache.put(e.key, 0, e.cost);
+    }
+    std::cout << std::setw(12) << name << std::setw(11)
+              << (policy == ArcEvictionPolicy::CostAware ? "CostAware" : "Recency") << std::setw(10) << misses
+              << std::setw(9) << std::fixed << std::setprecision(1) << 100.0 * misses / trace.size() << "%"
+              << std::setw(14) << std::setprecision(0) << miss_cost / 1000 << std::endl;
+}
+
+void bench_trace(const std::vector<TraceEntry>& trace, int capacity) {
+    std::cout << "trace: " << trace.size() << " requests, capacity " << capacity << "\n"
+              << std::setw(12) << "cache" << std::setw(11) << "policy" << std::setw(10) << "misses"
+              << std::setw(10) << "rate" << std::setw(14) << "miss cost ms" << std::endl;
+    for (auto policy : {ArcEvictionPolicy::Recency, ArcEvictionPolicy::CostAware}) {
+        replay<ArcSoftLimit>("soft-limit", policy, capacity, trace);
+    }
+    for (auto policy : {ArcEvictionPolicy::Recency, ArcEvictionPolicy::CostAware}) {
+        replay<ArcTrue>("arc", policy, capacity, trace);
+    }
+}
+
+// Кеш до інтрузивних вузлів: ключ тричі (мапа, LRU-список, LFU-набір), пошук за const std::string&,
+// тож виклик з string_view будує рядок, а просування перевставляє вузли списку і набору.
+template <typename T>
+class LegacyCache {
+    struct CacheEntry {
+        T value;
+        int useCount;
+        bool is_in_lfu;
+        typename std::list<std::string>::iterator lru_it;
+        typename std::set<std::pair<int, std::string>>::iterator lfu_it;
+    };
+    using map_type = std::unordered_map<std::string, CacheEntry>;
+
+    std::mutex cache_mutex;
+    map_type cache;
+    std::list<std::string> lru_keys;
+    std::set<std::pair<int, std::string>> lfu_keys;
+    size_t softLimit;
+    int lfuThreshold;
+
+    void remove_entry(typename map_type::iterator it) {
+        if (it->second.is_in_lfu) lfu_keys.erase(it->second.lfu_it);
+        else lru_keys.erase(it->second.lru_it);
+        cache.erase(it);
+    }
+    void evict() {
+        if (lfu_keys.size() > lru_keys.size()) remove_entry(cache.find(lfu_keys.begin()->second));
+        else if (!lru_keys.empty()) remove_entry(cache.find(lru_keys.back()));
+    }
+
+public:
+    explicit LegacyCache(int hard_limit) : softLimit(hard_limit), lfuThreshold(std::max(2, hard_limit / 20)) {}
+
+    T* put(const std::string& key, T&& value) {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        if (auto it = cache.find(key); it != cache.end()) remove_entry(it);
+        if (cache.size() >= softLimit) evict();
+        lru_keys.push_front(key);
+        auto it = cache.emplace(key, CacheEntry{std::move(value), 1, false, lru_keys.begin(), {}}).first;
+        return &it->second.value;
+    }
+
+    T* get(const std::string& key) {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto it = cache.find(key);
+        if (it == cache.end()) return nullptr;
+        CacheEntry& entry = it->second;
+        entry.useCount++;
+        if (entry.is_in_lfu) {
+            lfu_keys.erase(entry.lfu_it);
+            entry.lfu_it = lfu_keys.insert({entry.useCount, key}).first;
+        } else {
+            lru_keys.erase(entry.lru_it);
+            lru_keys.push_front(key);
+            entry.lru_it = lru_keys.begin();
+            if (entry.useCount > lfuThreshold) {
+                lru_keys.erase(entry.lru_it);
+                entry.lfu_it = lfu_keys.insert({entry.useCount, key}).first;
+                entry.is_in_lfu = true;
+            }
+        }
+        return &entry.value;
+    }
+};
+
+// Як SqlDrvPg::prepare: ключ приходить як string_view, при промаху - put()
+template <typename Cache>
+void get_or_put(Cache& cache, std::string_view sql) {
+    if constexpr (std::is_same_v<Cache, LegacyCache<int>>) {
+        if (!cache.get(std::string(sql))) cache.put(std::string(sql), 0);
+    } else {
+        if (!cache.get(sql)) cache.put(sql, 0);
+    }
+}
+
+template <typename Cache>
+void run_get_put(const char* name, int capacity, const std::vector<std::string>& keys, size_t ops) {
+    Cache cache(capacity);
+    for (const auto& key : keys) get_or_put(cache, key);  // прогрів
+
+    const size_t allocations_before = allocations;
+    const auto started = clock_type::now();
+    for (size_t i = 0; i < ops; ++i) get_or_put(cache, keys[(i * 7919) % keys.size()]);
+    const std::chrono::duration<double> elapsed = clock_type::now() - started;
+
+    std::cout << std::setw(12) << name << std::setw(12) << std::fixed << std::setprecision(2)
+              << ops / elapsed.count() / 1e6 << std::setw(14) << std::setprecision(2)
+              << static_cast<double>(allocations - allocations_before) / ops << std::endl;
+}
+
+void bench_get_put(size_t ops) {
+    // Ключі розміру типового згенерованого SELECT
+    std::vector<std::string> keys;
+    for (int i = 0; i < 1000; ++i) {
+        keys.push_back("SELECT master.id, master.name, master.city_id, city.name FROM customer AS master "
+                       "LEFT JOIN city ON city.id = master.city_id WHERE master.id = $1 /* " +
+                       std::to_string(i) + " */");
+    }
+    for (auto [label, capacity] : {std::pair{"all fit", 2000}, std::pair{"10% fit", 100}}) {
+        std::cout << "get/put, " << keys.size() << " keys, capacity " << capacity << " (" << label << ")\n"
+                  << std::setw(12) << "cache" << std::setw(12) << "Mops/s" << std::setw(14) << "allocs/op"
+                  << std::endl;
+        run_get_put<LegacyCache<int>>("legacy", capacity, keys, ops);
+        run_get_put<AdaptiveReplacementCache<int>>("soft-limit", capacity, keys, ops);
+        run_get_put<AdaptiveReplacementCache<int, ArcTrue>>("arc", capacity, keys, ops);
+    }
+}
+
+
+// Процесний кеш до шардування: один AdaptiveReplacementCache за одним м'ютексом, той самий API
+class SingleMutexCache {
+public:
+    using Handle = std::shared_ptr<const std::string>;
+    explicit SingleMutexCache(int hard_limit) : cache(hard_limit) {}
+    Handle get(std::string_view key) { return cache.get_copy(key).value_or(nullptr); }
+    Handle put(std::string_view key, std::string&& value) {
+        Handle handle = std::make_shared<const std::string>(std::move(value));
+        Handle copy = handle;
+        cache.put(key, std::move(copy));
+        return handle;
+    }
+
+private:
+    AdaptiveReplacementCache<Handle, ArcTrue> cache;
+};
+
+// Як кеш форм SqlGenius: get(), при промаху - put() згенерованого тексту; повертає операцій за секунду
+template <typename Cache>
+double shared_cache_rate(Cache& cache, const std::vector<std::string>& keys, int threads,
+                         std::chrono::milliseconds duration) {
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> ops{0};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            uint64_t local = 0;
+            size_t i = t * 7919;
+            while (!stop.load(std::memory_order_relaxed)) {
+                const std::string& key = keys[i++ % keys.size()];
+                if (!cache.get(key)) cache.put(key, std::string(key));
+                ++local;
+            }
+            ops += local;
+        });
+    }
+    std::this_thread::sleep_for(duration);
+    stop = true;
+    for (auto& w : workers) w.join();
+    return ops.load() * 1000.0 / duration.count();
+}
+
+void bench_threads(std::chrono::milliseconds duration) {
+    std::vector<std::string> keys;
+    for (int i = 0; i < 2000; ++i) keys.push_back("shape/" + std::to_string(i) + "/SELECT master.id FROM t");
+    const int capacity = 4096;
+
+    std::cout << "shared cache get/put, " << keys.size() << " keys, capacity " << capacity << ", Mops/s:\n"
+              << std::setw(8) << "threads" << std::setw(14) << "single mutex" << std::setw(14) << "sharded"
+              << std::endl;
+    for (int threads : {1, 2, 4, 8, 16, 32}) {
+        SingleMutexCache single(capacity);
+        ShardedReplacementCache<std::string> sharded(capacity);
+        const double single_rate = shared_cache_rate(single, keys, threads, duration);
+        const double sharded_rate = shared_cache_rate(sharded, keys, threads, duration);
+        std::cout << std::setw(8) << threads << std::setw(14) << std::fixed << std::setprecision(2)
+                  << single_rate / 1e6 << std::setw(14) << sharded_rate / 1e6 << std::endl;
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        const auto trace = argc > 1 ? load_trace(argv[1]) : synthetic_trace(200000);
+        bench_trace(trace, 100);
+        bench_get_put(2000000);
+        bench_threads(std::chrono::milliseconds(500));
+    } catch (const std::exception& e) {
+        std::cerr << "bench_arc: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,56 @@
+// Перевірка SQL, який FilterParser пише для полів різних типів (make check).
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "SqlGenius.h"
+
+using namespace ky;
+
+namespace {
+
+int failures = 0;
+
+void expect_sql(Rack& rack, sv type_name, sv filter_value, const std::string& expected_sql,
+                const std::vector<std::string>& expected_params) {
+  Table* table = rack.tables.get("event");
+  Field field{"at", {}, {}, rack.types.get(type_name)};
+  QModel model(table);
+  QField qfield(&model, &field, 0);
+  RField rfield(nullptr, qfield);
+  Recordset::Filter filter{rfield, string(filter_value)};
+
+  std::vector<std::string> params;
+  SqlBuilder sb(params);
+  try {
+    FilterParser(filter).write(sb, 0);
+  } catch (const std::exception& e) {
+    std::cerr << "FAIL " << type_name << " '" << filter_value << "': " << e.what() << std::endl;
+    ++failures;
+    return;
+  }
+  if (sb.str() != expected_sql || params != expected_params) {
+    std::cerr << "FAIL " << type_name << " '" << filter_value << "': got " << sb.str() << std::endl;
+    ++failures;
+  }
+}
+
+}  // namespace
+
+int main() {
+  Rack rack;
+  for (sv name : {"int", "date", "varchar(50)", "timestamp", "numeric(10,2)"}) rack.types.get(name);
+  type_t::finalize(rack);
+
+  expect_sql(rack, "int", "1|2|>10", "(master.at IN ($1::int, $2::int) OR master.at > $3::int)", {"1", "2", "10"});
+  expect_sql(rack, "date", "2024-01-01:2024-01-31", "(master.at BETWEEN $1::date AND $2::date)",
+             {"2024-01-01", "2024-01-31"});
+  expect_sql(rack, "varchar(50)", "Kyiv", "(master.at LIKE $1)", {"Kyiv%"});
+  // Нетипізовані поля: без перевірки і приведення, просте значення - префікс по тексту
+  expect_sql(rack, "timestamp", "2024-03", "(master.at::text LIKE $1)", {"2024-03%"});
+  expect_sql(rack, "timestamp", ">2024-03-01 10:00", "(master.at > $1)", {"2024-03-01 10:00"});
+  expect_sql(rack, "numeric(10,2)", "1.5:2.5", "(master.at BETWEEN $1 AND $2)", {"1.5", "2.5"});
+
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
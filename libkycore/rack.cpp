@@ -1,6 +1,8 @@
 #include "rack.h"
 
+#include <algorithm>
 #include <charconv>
+#include <sstream>
 #include <variant>
 
 namespace ky {
@@ -61,7 +63,12 @@ QField* QTable::getQField(svparts_t& parts) const {
     QTable* pqt = get_or_create(qtables, name, pt_ref, this, pf);
     return pqt->getQField(parts);
   }
-  return get_or_create(qfields, name, this, pf);
+  auto [it, inserted] = qfields.try_emplace(string{name}, nullptr);
+  if (inserted) {
+    // Слот видається лише новому полю, тож номери в межах моделі щільні
+    it->second = std::make_unique<QField>(this, pf, root().slot_count++);
+  }
+  return it->second.get();
 }
 
 string QTable::next_alias() {
@@ -130,9 +137,174 @@ const Layout* Rack::findBestLayout(sv name, const QModel* qmodel, const std::str
   return best_layout;
 }
 
-string Rack::generate_sql() const {
-  // Ця функція призначена для генерації SQL-схеми, але наразі не реалізована.
-  return "-- SQL schema generation is not implemented yet.\n";
+namespace {
+
+/// Індекс, якого потребують запити SqlGenius: фільтри (!searchable, !unique) та дочірні списки (link).
+struct IndexSpec {
+  string table;
+  string column;
+  bool trigram = false;  // gin (column gin_trgm_ops) - для LIKE за текстом; інакше btree
+  bool unique = false;
+
+  string name() const { return table + "_" + column + (unique ? "_key" : trigram ? "_trgm_idx" : "_idx"); }
+
+  string ddl() const {
+    return string("CREATE ") + (unique ? "UNIQUE " : "") + "INDEX IF NOT EXISTS " + name() + " ON " + table +
+           (trigram ? " USING gin (" + column + " gin_trgm_ops);\n" : " (" + column + ");\n");
+  }
+
+  /// Чи покриває індекс з каталогу (pg_indexes.indexdef) цей: той самий метод і провідна колонка.
+  bool covered_by(sv indexdef) const {
+    if (unique && indexdef.rfind("CREATE UNIQUE", 0) != 0) return false;
+    const string needle = trigram ? "USING gin (" + column + " gin_trgm_ops" : "USING btree (" + column;
+    auto pos = indexdef.find(needle);
+    if (pos == sv::npos) return false;
+    pos += needle.size();
+    return pos < indexdef.size() && (indexdef[pos] == ')' || indexdef[pos] == ',' || indexdef[pos] == ' ');
+  }
+};
+
+/// Поля таблиці в сталому порядку: id першим, далі за іменем.
+std::vector<const Field*> sorted_fields(const Table& table) {
+  std::vector<const Field*> fields;
+  for (const auto& [name, field] : table.fields.get_map()) fields.push_back(field);
+  std::sort(fields.begin(), fields.end(), [](const Field* a, const Field* b) {
+    if ((a->name == "id") != (b->name == "id")) return a->name == "id";
+    return a->name < b->name;
+  });
+  return fields;
+}
+
+/// Значення default(...) як SQL: числа та вирази на кшталт current_date - як є, решта - рядковий літерал.
+string sql_default(sv value) {
+  static const std::unordered_set<sv> keywords{"current_date", "current_timestamp", "now()", "true", "false", "null"};
+  double num;
+  auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), num);
+  if ((ec == std::errc() && ptr == value.data() + value.size()) || keywords.count(value)) return string(value);
+  string literal = "'";
+  for (char c : value) {
+    if (c == '\'') literal += '\'';
+    literal += c;
+  }
+  return literal + "'";
+}
+
+/// Дочірні списки (list всередині form): фільтруються за полем link, тож воно потребує індексу.
+void collect_link_indexes(const Rack& rack, const LayoutNode* node, bool in_form, std::vector<IndexSpec>& specs) {
+  if (!node) return;
+  if (in_form && node->tag == "list") {
+    auto table_it = node->attrs.find("table");
+    if (table_it != node->attrs.end()) {
+      // Як у View::Builder: link за замовчуванням - ім'я таблиці; "поле:колонка" - лише поле
+      sv link = get_default(node->attrs, string("link"), table_it->second);
+      link = link.substr(0, link.find(':'));
+      const Table* table = rack.tables[table_it->second];
+      auto field_it = table->fields.get_map().find(link);
+      if (field_it != table->fields.get_map().end()) {
+        specs.push_back({table->name, field_it->second->sqlName()});
+      } else {
+        std::cerr << "Warning: link field '" << link << "' not found in table '" << table->name << "'." << std::endl;
+      }
+    }
+  }
+  in_form = in_form || node->tag == "form";
+  for (const auto& child : node->nodes) collect_link_indexes(rack, child.get(), in_form, specs);
+}
+
+}  // namespace
+
+/**
+ * @brief Генерує DDL схеми з фіналізованого Rack.
+ * @details Таблиці з колонками type_t::sql(), NOT NULL для !required, UNIQUE для !unique,
+ * default(...) та check(...); зовнішні ключі для ref(...) - окремими ALTER TABLE в кінці,
+ * щоб порядок таблиць не мав значення. Типи без type_t::sql() - за іменем зі специфікації.
+ * Увесь текст можна виконувати повторно: IF NOT EXISTS, а обмеження FK іменовані й перевіряються
+ * за pg_constraint. Індекси - під шляхи доступу SqlGenius:
+ * !searchable текстові поля - trigram (LIKE), решта - btree; поля link дочірніх списків - btree.
+ * @param missing_indexes_only Лише індекси, яких немає в каталозі підключеної БД (pg_indexes).
+ * @return Текст SQL.
+ */
+string Rack::generate_sql(bool missing_indexes_only) const {
+  std::vector<const Table*> sorted_tables;
+  for (const auto& [name, table] : tables.get_map()) sorted_tables.push_back(table);
+  std::sort(sorted_tables.begin(), sorted_tables.end(),
+            [](const Table* a, const Table* b) { return a->name < b->name; });
+
+  std::stringstream ddl, fkeys;
+  std::vector<IndexSpec> specs;
+  for (const Table* table : sorted_tables) {
+    ddl << "CREATE TABLE IF NOT EXISTS " << table->name << " (";
+    bool first = true;
+    for (const Field* field : sorted_fields(*table)) {
+      // Типи без власного відображення (timestamp, numeric(5, 2)...) пишуться так, як у специфікації
+      string type_sql = field->type->sql();
+      if (type_sql.empty()) type_sql = field->type->name;
+      ddl << (first ? "\n  " : ",\n  ") << field->sqlName() << " " << type_sql;
+      first = false;
+
+      const bool unique = field->flags.count("unique") > 0;
+      if (field->flags.count("required")) ddl << " NOT NULL";
+      if (unique) ddl << " UNIQUE";
+      if (auto it = field->attrs.find("default"); it != field->attrs.end()) ddl << " DEFAULT " << sql_default(it->second);
+      if (auto it = field->attrs.find("check"); it != field->attrs.end()) ddl << " CHECK (" << it->second << ")";
+
+      if (field->type->is_ref()) {
+        // Ім'я як у PostgreSQL за замовчуванням (до 63 байт), тож повторний запуск знаходить
+        // і обмеження, створені ще без імені
+        const string fkey = (table->name + "_" + field->sqlName() + "_fkey").substr(0, 63);
+        fkeys << "DO $$ BEGIN\n"
+              << "  IF NOT EXISTS (SELECT 1 FROM pg_constraint WHERE conname = '" << fkey << "' AND conrelid = '"
+              << table->name << "'::regclass) THEN\n"
+              << "    ALTER TABLE " << table->name << " ADD CONSTRAINT " << fkey << " FOREIGN KEY ("
+              << field->sqlName() << ") REFERENCES " << field->type->ref()->name << " (id);\n"
+              << "  END IF;\nEND $$;\n";
+      }
+      // UNIQUE вже є btree-індексом; у diff-режимі його теж перевіряємо
+      if (unique) specs.push_back({table->name, field->sqlName(), false, true});
+      if (field->flags.count("searchable")) {
+        const bool textual = field->type->bin() == type_t::bin_t::text;
+        if (textual || !unique) specs.push_back({table->name, field->sqlName(), textual});
+      }
+    }
+    ddl << "\n);\n\n";
+  }
+  for (const auto& layout : layouts) collect_link_indexes(*this, layout.root_node.get(), false, specs);
+
+  // Дублікати (поле і searchable, і link) - один індекс; btree покриває UNIQUE тієї ж колонки
+  std::vector<IndexSpec> indexes;
+  for (const auto& spec : specs) {
+    bool covered = std::any_of(indexes.begin(), indexes.end(), [&](const IndexSpec& other) {
+      return other.table == spec.table && other.column == spec.column && other.trigram == spec.trigram &&
+             (other.unique || !spec.unique);
+    });
+    if (!covered) indexes.push_back(spec);
+  }
+
+  if (missing_indexes_only) {
+    if (!sqldb) throw std::runtime_error("Rack::generate_sql: no database connection for the index diff.");
+    auto catalog = sqldb->query(
+        "SELECT tablename, indexdef FROM pg_indexes WHERE schemaname = current_schema()", {});
+    std::erase_if(indexes, [&](const IndexSpec& spec) {
+      for (int row = 0; row < catalog->row_count(); ++row) {
+        if (catalog->get_text(row, 0) == sv(spec.table) && spec.covered_by(catalog->get_text(row, 1).value_or(""))) {
+          return true;
+        }
+      }
+      return false;
+    });
+  }
+
+  std::stringstream ss;
+  if (std::any_of(indexes.begin(), indexes.end(), [](const IndexSpec& spec) { return spec.trigram; })) {
+    ss << "CREATE EXTENSION IF NOT EXISTS pg_trgm;\n\n";
+  }
+  if (!missing_indexes_only) ss << ddl.str() << fkeys.str() << (fkeys.tellp() > 0 ? "\n" : "");
+  for (const auto& spec : indexes) {
+    // UNIQUE у повному DDL - обмеження колонки; окремим індексом - лише якщо його бракує в БД
+    if (spec.unique && !missing_indexes_only) continue;
+    ss << spec.ddl();
+  }
+  return ss.str();
 }
 
 /*
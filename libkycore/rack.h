@@ -1,10 +1,14 @@
 #pragma once
 // @preserve all comments
+#include <algorithm>
 #include <any>
 #include <atomic>
 #include <cassert>
+#include <charconv>
+#include <chrono>
 #include <fstream>
 #include <functional>
+#include <future>
 #include <iostream>  // Для std::cout
 #include <limits>
 #include <memory>
@@ -23,6 +27,7 @@
 
 namespace ky {
 // Попередні оголошення
+template <class T> class namemap;
 struct Field;
 struct Table;
 struct Layout;
@@ -38,6 +43,24 @@ using vector_prf = std::vector<RField*>;
 
 using attrs_t = std::unordered_map<string, string>;
 using roid_t = uint32_t;  // Random Object ID based on RUIDGen
+using date_t = std::chrono::sys_days;
+
+/// Розбір дати ISO (DateStyle ISO): YYYY-MM-DD. nullopt - рядок не є коректною датою.
+inline std::optional<date_t> parse_iso_date(sv v) {
+  int y = 0;
+  unsigned m = 0, d = 0;
+  const char* p = v.data();
+  const char* end = p + v.size();
+  auto r = std::from_chars(p, end, y);
+  if (r.ec != std::errc() || r.ptr == end || *r.ptr != '-') return std::nullopt;
+  r = std::from_chars(r.ptr + 1, end, m);
+  if (r.ec != std::errc() || r.ptr == end || *r.ptr != '-') return std::nullopt;
+  r = std::from_chars(r.ptr + 1, end, d);
+  if (r.ec != std::errc() || r.ptr != end) return std::nullopt;
+  std::chrono::year_month_day ymd{std::chrono::year{y}, std::chrono::month{m}, std::chrono::day{d}};
+  if (!ymd.ok()) return std::nullopt;
+  return date_t{ymd};
+}
 
 using fields_t = namemap<Field>;
 using tables_t = namemap<Table>;
@@ -130,6 +153,11 @@ struct type_t {
   const string sql() const;
   const string sqlSufix() const;
 
+  /// Як значення колонки цього типу читається з бінарного результату SqlDB.
+  /// none - тип не має бінарного аксесора, колонку читаємо лише як текст.
+  enum class bin_t { none, int32, date, text };
+  bin_t bin() const;
+
   // Статичний метод для фіналізації колекції типів
   static void finalize(Rack& rack);
 
@@ -158,8 +186,10 @@ struct QTable;
 struct QField {
   const Field* pf;
   const QTable* pqt;
+  /// Щільний номер поля в межах QModel (0, 1, 2, ...); Record тримає RField у слоті з цим номером.
+  const uint32_t slot;
   QField() = delete;
-  explicit QField(const QTable* pqt, const Field* pf) : pf(pf), pqt(pqt) {
+  explicit QField(const QTable* pqt, const Field* pf, uint32_t slot) : pf(pf), pqt(pqt), slot(slot) {
     assert(pf != nullptr && "Вказівник на Field не може бути нульовим");
     assert(pqt != nullptr && "Вказівник на QTable не може бути нульовим");
   };
@@ -185,6 +215,16 @@ struct QTable {
   virtual bool isMaster() const { return false; }
   virtual ~QTable() = default;
 
+  /// Кореневий QTable (QModel), якому належать слоти полів.
+  const QTable& root() const { return ppqt ? ppqt->root() : *this; }
+  /// Кількість слотів, виданих полям моделі; має сенс лише для кореня.
+  uint32_t slotCount() const { return root().slot_count; }
+  /// Знаходить вже створений QField цієї таблиці; нових не створює.
+  const QField* findQField(const Field* pf) const {
+    auto it = qfields.find(pf->name);
+    return it == qfields.end() ? nullptr : it->second.get();
+  }
+
 protected:
   // Метод тепер const, оскільки він змінює лише mutable-члени (кеш).
   QField* getQField(svparts_t& parts) const;
@@ -206,6 +246,8 @@ private:
   // Контейнери кешу позначено як mutable, щоб їх можна було заповнювати "на льоту".
   mutable qmap<QTable> qtables;
   mutable qmap<QField> qfields;
+  // Лічильник слотів, використовується лише на корені.
+  mutable uint32_t slot_count = 0;
 };
 
 struct QModel : QTable {
@@ -370,7 +412,66 @@ public:
     /// @brief Повертає значення комірки за індексами рядка та колонки.
     /// @return Повертає string_view на дані. Якщо значення NULL, повертає порожній string_view.
     virtual ky::optsv get_value(int row, int col) const = 0;
+
+    /// @brief Типізовані аксесори, вибір аксесора - за type_t::bin() колонки.
+    /// @details Базова реалізація розбирає текст з get_value(). Драйвер перевизначає їх
+    /// для бінарного результату (Statement::binary), де розбір тексту не потрібен.
+    /// Для бінарного результату get_value() повертає сирі байти, тож для int/date колонок
+    /// він придатний лише через ці аксесори. Для text/varchar байти збігаються з текстом.
+    virtual std::optional<int32_t> get_int32(int row, int col) const { return parse_int<int32_t>(get_value(row, col)); }
+    virtual std::optional<int64_t> get_int64(int row, int col) const { return parse_int<int64_t>(get_value(row, col)); }
+    virtual std::optional<date_t> get_date(int row, int col) const { return parse_date(get_value(row, col)); }
+    ky::optsv get_text(int row, int col) const { return get_value(row, col); }
     std::any rfields;
+
+  protected:
+    template <typename I>
+    static std::optional<I> parse_int(optsv v) {
+      if (!v) return std::nullopt;
+      I num{};
+      auto [ptr, ec] = std::from_chars(v->data(), v->data() + v->size(), num);
+      if (ec != std::errc() || ptr != v->data() + v->size()) {
+        throw std::runtime_error("SqlDB::Result: not an integer: " + string(*v));
+      }
+      return num;
+    }
+
+    /// Текстова дата у форматі ISO (DateStyle ISO): YYYY-MM-DD.
+    static std::optional<date_t> parse_date(optsv v) {
+      if (!v) return std::nullopt;
+      auto date = parse_iso_date(*v);
+      if (!date) {
+        throw std::runtime_error("SqlDB::Result: not a date: " + string(*v));
+      }
+      return date;
+    }
+  };
+
+  /// @brief Потік рядків результату, що віддається порціями обмеженого розміру.
+  /// @details Поки потік живий, він тримає з'єднання драйвера.
+  class Stream {
+  public:
+    virtual ~Stream() = default;
+
+    /// @brief Повертає наступну порцію рядків або nullptr, коли рядки скінчились.
+    /// Попередню порцію можна звільнити одразу - порції незалежні.
+    virtual std::unique_ptr<Result> next_chunk() = 0;
+  };
+
+  /// @brief Помилка сервера з кодом SQLSTATE (напр. "23505"); порожній код - помилка клієнта чи з'єднання.
+  struct Error : std::runtime_error {
+    string sqlstate;
+    Error(const string& message, string sqlstate) : std::runtime_error(message), sqlstate(std::move(sqlstate)) {}
+    /// Класи 22 (дані) і 23 (обмеження): сервер відхилив значення рядків, а не сам запит.
+    bool rowsRejected() const { return sqlstate.starts_with("22") || sqlstate.starts_with("23"); }
+  };
+
+  /// @brief Один запит у пакеті для query_pipeline().
+  struct Statement {
+    sv sql;
+    std::vector<string> params;
+    bool once = false;  ///< true - як query_once(), без кешу підготовлених запитів
+    bool binary = false;  ///< результат у бінарному форматі, читати типізованими аксесорами
   };
 
   virtual ~SqlDB() = default;
@@ -385,11 +486,145 @@ public:
   /// Ідеально для унікальних динамічних запитів, як-от SELECT ... IN (...)
   virtual std::unique_ptr<Result> query_once(sv sql, const std::vector<string>& params) = 0;
 
+  /// Виконати пакет запитів, що повертають дані, за один мережевий обмін на одному з'єднанні.
+  /// Результати повертаються в порядку запитів у пакеті; запит без даних (UPDATE у пакеті)
+  /// дає порожній Result. Помилка будь-якого запиту кидає виняток для всього пакета.
+  /// Базова реалізація виконує запити послідовно - драйвер може перевизначити її (pipeline).
+  virtual std::vector<std::unique_ptr<Result>> query_pipeline(const std::vector<Statement>& batch) {
+    std::vector<std::unique_ptr<Result>> results;
+    results.reserve(batch.size());
+    for (const auto& st : batch) {
+      results.push_back(st.once ? query_once(st.sql, st.params) : query(st.sql, st.params));
+    }
+    return results;
+  }
+
+  /// Виконати запит, результат якого читається потоком порцій до chunk_rows рядків.
+  /// Пам'ять на стороні клієнта не залежить від загальної кількості рядків.
+  /// Базова реалізація віддає весь результат query() однією порцією.
+  virtual std::unique_ptr<Stream> query_stream(sv sql, const std::vector<string>& params,
+                                               [[maybe_unused]] int chunk_rows) {
+    class WholeStream : public Stream {
+      std::unique_ptr<Result> res;
+    public:
+      explicit WholeStream(std::unique_ptr<Result> r) : res(std::move(r)) {}
+      std::unique_ptr<Result> next_chunk() override { return std::move(res); }
+    };
+    return std::make_unique<WholeStream>(query(sql, params));
+  }
+
   /// Виконати запит, що не повертає дані (INSERT, UPDATE, DELETE).
   /// @param sql SQL-запит.
   /// @param params Вектор параметрів.
   /// @return Повертає кількість змінених рядків.
   virtual int execute(sv sql, const std::vector<string>& params) = 0;
+
+  /// @name Асинхронні варіанти query / query_pipeline / execute.
+  /// Не блокують викликаючий потік; sql та params копіюються, тож можуть бути тимчасовими.
+  /// Помилка запиту передається як виняток з future::get().
+  /// Базова реалізація виконує синхронний виклик в окремому потоці (std::async).
+  /// У відкритій транзакції потоку виклик виконується одразу і в ній, future вже готовий.
+  /// @{
+  virtual std::future<std::unique_ptr<Result>> query_async(sv sql, std::vector<string> params) {
+    if (inTransaction()) return run_now([&] { return query(sql, params); });
+    return std::async(std::launch::async,
+                      [this, sql = string(sql), params = std::move(params)] { return query(sql, params); });
+  }
+
+  virtual std::future<std::vector<std::unique_ptr<Result>>> query_pipeline_async(const std::vector<Statement>& batch) {
+    if (inTransaction()) return run_now([&] { return query_pipeline(batch); });
+    std::vector<string> sqls;
+    sqls.reserve(batch.size());
+    for (const auto& st : batch) sqls.emplace_back(st.sql);
+    return std::async(std::launch::async, [this, sqls = std::move(sqls), batch = batch]() mutable {
+      for (size_t i = 0; i < batch.size(); ++i) batch[i].sql = sqls[i];
+      return query_pipeline(batch);
+    });
+  }
+
+  virtual std::future<int> execute_async(sv sql, std::vector<string> params) {
+    if (inTransaction()) return run_now([&] { return execute(sql, params); });
+    return std::async(std::launch::async,
+                      [this, sql = string(sql), params = std::move(params)] { return execute(sql, params); });
+  }
+  /// @}
+
+  /// @name Транзакції.
+  /// Транзакція прив'язана до потоку, що її почав: поки вона відкрита, синхронні виклики
+  /// цього потоку (query, query_pipeline, execute, ...) виконуються в ній.
+  /// Асинхронні варіанти цього потоку виконуються в ній синхронно; інші потоки в транзакцію не входять.
+  /// Вкладені транзакції не підтримуються.
+  /// Зазвичай використовується через TransactionGuard (transaction.h).
+  /// @{
+  virtual void beginTransaction() = 0;
+  /// Помилка COMMIT кидає виняток; транзакція в будь-якому разі завершена.
+  virtual void commit() = 0;
+  virtual void rollback() = 0;
+  virtual bool inTransaction() const = 0;
+  /// @}
+
+  /// @name Масове завантаження рядків (bulk_import).
+  /// @{
+  /// @brief Колонка для bulk_import(): ім'я в БД (Field::sqlName()) і тип для перевірки та кодування.
+  struct ImportColumn {
+    string name;
+    const type_t* type = nullptr;
+  };
+
+  /// @brief Рядок, що не потрапив до БД.
+  struct ImportError {
+    size_t row;      ///< індекс у вхідних rows
+    string column;   ///< колонка, що не пройшла type_t::validate; порожня - порцію відхилив сервер
+    string message;
+  };
+
+  struct ImportReport {
+    size_t imported = 0;
+    std::vector<ImportError> errors;
+  };
+
+  /// Значення рядка в порядку колонок; nullopt - NULL.
+  /// Для не текстових типів (int, date, ref) порожній рядок теж вважається NULL.
+  using ImportRow = std::vector<optsv>;
+
+  /// Завантажити рядки в таблицю порціями по batch_rows.
+  /// Кожна порція спершу перевіряється type_t::validate поколонково; рядки з помилками
+  /// потрапляють у звіт, решта порції відправляється драйверу (import_batch()).
+  /// Колонки без типізації (type_t::bin_t::none) перевіряє лише сервер.
+  /// Якщо сервер відхиляє дані порції (Error::rowsRejected()), вона ділиться навпіл і відправляється
+  /// знов, доки погані рядки не залишаться поодинці: у звіт потрапляють лише вони, з помилкою сервера.
+  /// Інші помилки (немає таблиці чи прав, обрив з'єднання) кидаються одразу.
+  /// У відкритій транзакції кожна спроба йде під SAVEPOINT, тож помилка її не перериває.
+  ImportReport bulk_import(sv table, const std::vector<ImportColumn>& columns,
+                           const std::vector<ImportRow>& rows, size_t batch_rows = 10000);
+  /// @}
+
+protected:
+  /// Виконує f одразу і повертає готовий future з результатом або винятком f.
+  template <class F>
+  static auto run_now(F&& f) -> std::future<decltype(f())> {
+    std::promise<decltype(f())> promise;
+    try {
+      promise.set_value(f());
+    } catch (...) {
+      promise.set_exception(std::current_exception());
+    }
+    return promise.get_future();
+  }
+
+  /// Записати порцію вже перевірених рядків одним запитом: або вся порція, або виняток.
+  /// Помилку сервера кидає як Error з SQLSTATE - за ним bulk_import() вирішує, чи шукати погані рядки.
+  /// @return Кількість записаних рядків.
+  /// Базова реалізація - один INSERT ... VALUES на порцію; драйвер може перевизначити її (COPY).
+  virtual size_t import_batch(sv table, const std::vector<ImportColumn>& columns,
+                              const std::vector<const ImportRow*>& rows);
+
+private:
+  /// import_batch() як окрема спроба: у транзакції - під SAVEPOINT.
+  size_t import_attempt(sv table, const std::vector<ImportColumn>& columns, const std::vector<const ImportRow*>& rows);
+  /// Завантажує rows, ділячи навпіл порції, які відхилив сервер; index - індекси rows у вхідних даних.
+  void import_bisect(sv table, const std::vector<ImportColumn>& columns, const std::vector<const ImportRow*>& rows,
+                     const std::vector<size_t>& index, ImportReport& report);
 };
 
 struct Rack {
@@ -406,8 +641,9 @@ struct Rack {
   mutable namemap<QModel> qmodels{};
 
   static const Rack& get();
-  const Layout* Rack::findBestLayout(sv name, const QModel* qmodel, const string& media, const string& usage) const;
-  string generate_sql() const;
+  const Layout* findBestLayout(sv name, const QModel* qmodel, const string& media, const string& usage) const;
+  /// DDL схеми з індексами під запити SqlGenius; true - лише індекси, яких бракує в підключеній БД.
+  string generate_sql(bool missing_indexes_only = false) const;
   bool connect(sv connection_string);
   void finalize();
 
@@ -2,12 +2,18 @@
 
 #include "rec.h"
 
+#include <algorithm>
 #include <any>
 #include <cassert>
+#include <charconv>
+#include <chrono>
+#include <future>
+#include <set>
 #include <stdexcept>
 
 #include "SqlGenius.h"  // Підключаємо наш генератор SQL
 #include "rack.h"       // Для доступу до SqlDB
+#include "transaction.h"  // TransactionGuard
 
 namespace ky {
 
@@ -43,6 +49,12 @@ void RField::setId(sv new_id) const {
   }
 }
 
+void RField::own() {
+  if (is_null || val.data() == mval.data()) return;
+  mval = val;
+  val = mval;
+}
+
 void RField::flush() {
   is_modified = false;
   is_null = true;
@@ -58,32 +70,30 @@ Record::Record(const RKey& rkey) : rkey(rkey) {}
 
 RField& Record::getRField(sv name) {
   const QField* pqf = rkey.tgtQModel->getQField(name);
+  assert(&pqf->pqt->root() == rkey.tgtQModel && "QField must belong to the record's QModel");
 
-  for (const auto& rf_ptr : rfields) {
-    if (&rf_ptr->qfield == pqf) {
-      return *rf_ptr;
-    }
+  if (pqf->slot < slots.size() && slots[pqf->slot]) {
+    return *slots[pqf->slot];
   }
 
-  RField& rf = *rfields.emplace_back(std::make_unique<RField>(RField{this, *pqf}));
+  RField& rf = rfields.emplace(rkey.tgtQModel->slotCount(), this, *pqf);
+  if (pqf->slot >= slots.size()) slots.resize(rkey.tgtQModel->slotCount(), nullptr);
+  slots[pqf->slot] = &rf;
+
   auto t = pqf->pf->type;
   if (pqf->pqt->isMaster() && t->is_ref()) {
     // NOTE: qmodels - dynamycaly updates
     const QModel* p_qmodel = Rack::get().qmodels.get(t->ref()->name);
     assert(p_qmodel != nullptr);
-    rf.rkey = std::make_unique<RKey>(rf, *p_qmodel);
+    rf.rkey.emplace(rf, *p_qmodel);
   }
   return rf;
 }
 
 RField* Record::getRField(const QTable* pqt, const Field* pf) {
-  for (const auto& rf_ptr : rfields) {
-    const auto& qfield = rf_ptr->qfield;
-    if (qfield.pqt == pqt && qfield.pf == pf) {
-      return rf_ptr.get();
-    }
-  }
-  return nullptr;
+  const QField* pqf = pqt->findQField(pf);
+  if (!pqf || pqf->slot >= slots.size()) return nullptr;
+  return slots[pqf->slot];
 }
 
 void Record::New() {
@@ -91,19 +101,19 @@ void Record::New() {
   is_new = true;
 
   // 2. Ітеруємо по всіх полях і встановлюємо значення за замовчуванням.
-  for (const auto& rfield_ptr : rfields) {
-    const auto& qfield = rfield_ptr->qfield;
+  for (auto& rfield : rfields.all()) {
+    const auto& qfield = rfield.qfield;
 
     // Перевіряємо, чи є у поля default-значення в метаданих (в атрибутах)
     auto it = qfield.pf->attrs.find("default");
     if (it != qfield.pf->attrs.end()) {
       // Встановлюємо значення, але не позначаємо поле як is_modified,
       // оскільки це не зміна, зроблена користувачем.
-      rfield_ptr->modify(it->second);
-      rfield_ptr->is_modified = false;  // Важливо! Default - це не зміна користувача.
+      rfield.modify(it->second);
+      rfield.is_modified = false;  // Важливо! Default - це не зміна користувача.
     } else {
       // Для інших полів просто скидаємо значення.
-      rfield_ptr->flush();  //
+      rfield.flush();  //
     }
   }
 }
@@ -119,29 +129,64 @@ void Record::doLoad(const vector_prf& fields_to_load) {
   if (sql.empty()) return;
 
   // 3. Отримуємо параметри і виконуємо запит
-  auto params = genius.getOrderedParams(sql);
+  auto params = genius.takeParams();
   auto& db = Rack::get().sqldb;  // Отримуємо доступ до об'єкта БД
 
-  // Припускаємо, що у SqlDB є метод query, що повертає результат
-  std::unique_ptr<SqlDB::Result> res = db->query(sql, params);
-
   // 4. Заповнюємо поля даними з відповіді
+  applyLoad(fields_to_load, db->query(sql, params));
+}
+
+void Record::applyLoad(const vector_prf& fields_to_load, std::unique_ptr<SqlDB::Result> res) {
   if (res && res->row_count() > 0) {
-    for (size_t i = 0; i < fields_to_load.size(); ++i) {
-      optsv value_opt = res->get_value(0, i);  // Беремо дані з першого рядка
-      fields_to_load[i]->set(value_opt);  // Метод RField::set() оновлює val і скидає is_modified
-    }
-    is_new = false;  // Якщо щось завантажили, запис вже не новий
+    applyRow(fields_to_load, std::move(res), 0, 0);  // Беремо дані з першого рядка
+    return;
+  }
+  // Запис не знайдено: завантажувані поля - NULL, решта ще може дивитись на попередній результат
+  for (RField* rf : fields_to_load) rf->flush();
+  releaseLoaded(fields_to_load);
+}
+
+void Record::applyRow(const vector_prf& fields_to_load, std::shared_ptr<SqlDB::Result> res, int row, int first_col) {
+  for (size_t i = 0; i < fields_to_load.size(); ++i) {
+    optsv value_opt = res->get_value(row, first_col + i);
+    fields_to_load[i]->set(value_opt);  // Метод RField::set() оновлює val і скидає is_modified
+  }
+  is_new = false;  // Якщо щось завантажили, запис вже не новий
+  // RField::set() зберігає string_view на дані результату, тому тримаємо його до наступного завантаження
+  if (loaded_res != res) releaseLoaded(fields_to_load);
+  loaded_res = std::move(res);
+}
+
+void Record::releaseLoaded(const vector_prf& reloaded) {
+  if (!loaded_res) return;
+  // Поля поза reloaded (Refresh, Read-after-Write лише видимих полів) копіюють значення до себе
+  for (auto& rfield : rfields.all()) {
+    if (std::find(reloaded.begin(), reloaded.end(), &rfield) == reloaded.end()) rfield.own();
   }
+  loaded_res.reset();
 }
 
 void Record::Load() { doLoad(this->visible_fields); }
 
+std::future<void> Record::LoadAsync() {
+  const vector_prf fields_to_load = this->visible_fields;
+  SqlGenius genius(this);
+  std::string sql = genius.gen_select_one(fields_to_load);
+  if (sql.empty()) return std::async(std::launch::deferred, [] {});
+
+  // Запит вже в польоті; поля заповнюються в потоці, що викличе get()/wait() -
+  // Record не потокобезпечний, тож це має бути потік сесії.
+  auto pending = Rack::get().sqldb->query_async(sql, genius.takeParams());
+  return std::async(std::launch::deferred, [this, fields_to_load, pending = std::move(pending)]() mutable {
+    applyLoad(fields_to_load, pending.get());
+  });
+}
+
 void Record::Refresh() {
   vector_prf unmodified_fields;
-  for (const auto& rfield_ptr : rfields) {
-    if (!rfield_ptr->is_modified) {
-      unmodified_fields.push_back(rfield_ptr.get());
+  for (auto& rfield : rfields.all()) {
+    if (!rfield.is_modified) {
+      unmodified_fields.push_back(&rfield);
     }
   }
   doLoad(unmodified_fields);
@@ -150,47 +195,215 @@ void Record::Refresh() {
 void Record::SetVisibleFields(const vector_prf& fields) { this->visible_fields = fields; }
 
 void Record::Save() {
+  const vector_prf fields_to_load = this->visible_fields;
   SqlGenius genius(this);
-  std::string sql;
+  std::string sql = genius.gen_save(fields_to_load);
+  if (sql.empty()) {
+    // Нічого не було змінено, виходимо
+    return;
+  }
+  // Запис і Read-after-Write - один запит; query() іде у транзакцію потоку, якщо вона відкрита
+  applySave(fields_to_load, Rack::get().sqldb->query(sql, genius.takeParams()));
+}
 
-  // 1. Визначаємо, яку операцію виконати: INSERT чи UPDATE
-  if (is_new) {
-    sql = genius.gen_insert();  //
-  } else {
-    sql = genius.gen_update();  //
+void Record::applySave(const vector_prf& fields_to_load, std::unique_ptr<SqlDB::Result> res) {
+  if (!res || res->row_count() == 0) {
+    throw std::runtime_error(is_new ? "Failed to retrieve new ID after INSERT." : "Record to update was not found.");
   }
+  // Оновлюємо ID нашого запису з відповіді БД; для UPDATE він той самий
+  if (is_new) rkey.srcRField->setId(res->get_value(0, 0).value_or(""));
+  is_new = false;
+  // <<<<<<<<<<<<< Read-after-Write >>>>>>>>>>>>>
+  // Стан вже прочитаний тим самим запитом (CTE ... RETURNING *), разом з тригерами та JOIN-полями
+  applyRow(fields_to_load, std::move(res), 0, 1);
+  onSaved();
+}
 
+std::future<void> Record::SaveAsync() {
+  const vector_prf fields_to_load = this->visible_fields;
+  SqlGenius genius(this);
+  std::string sql = genius.gen_save(fields_to_load);
   if (sql.empty()) {
-    // Нічого не було змінено, виходимо
-    return;
+    // Нічого не було змінено
+    return std::async(std::launch::deferred, [] {});
   }
 
-  // 2. Отримуємо параметри та виконуємо запит
-  auto params = genius.getOrderedParams(sql);
+  // Запис і Read-after-Write - один запит, отже один обмін з БД
+  auto pending = Rack::get().sqldb->query_async(sql, genius.takeParams());
+  return std::async(std::launch::deferred, [this, fields_to_load, pending = std::move(pending)]() mutable {
+    applySave(fields_to_load, pending.get());
+  });
+}
+
+void Record::SaveBatch(const std::vector<Record*>& records) {
   auto& db = Rack::get().sqldb;
 
-  if (is_new) {
-    // Для INSERT нам потрібно отримати повернутий ID
-    // Припускаємо, що у SqlDB є метод, що може повернути результат
-    std::unique_ptr<SqlDB::Result> res = db->query(sql, params);
-    if (res && res->row_count() > 0) {
-      // Оновлюємо ID нашого запису з відповіді БД
-      // Ця логіка потребуватиме реалізації отримання ID з RKey
-      // **ВИПРАВЛЕНО:** Використовуємо rkey для встановлення ID
-      rkey.srcRField->setId(res->get_value(0, 0).value_or(""));
-      is_new = false;
-    } else {
-      throw std::runtime_error("Failed to retrieve new ID after INSERT.");
+  // 1. UPDATE - по одному на запис; нові записи чекають своєї хвилі INSERT
+  std::vector<Record*> pending;
+  std::vector<Record*> updated;
+  std::vector<std::string> sqls;  // Statement::sql - string_view, тексти живуть тут
+  std::vector<std::vector<std::string>> params;
+  for (Record* rec : records) {
+    if (rec->is_new) {
+      pending.push_back(rec);
+      continue;
     }
-  } else {
-    // Для UPDATE нам не потрібен результат, лише кількість змінених рядків
-    db->execute(sql, params);
+    SqlGenius genius(rec);
+    std::string sql = genius.gen_update();
+    if (sql.empty()) continue;  // Нічого не було змінено
+    params.push_back(genius.takeParams());
+    sqls.push_back(std::move(sql));
+    updated.push_back(rec);
   }
+  if (sqls.empty() && pending.empty()) return;
 
-  // 3. <<<<<<<<<<<<< Read-after-Write >>>>>>>>>>>>>
-  // Перезавантажуємо стан об'єкта з БД, щоб гарантувати консистентність
-  Load();
+  std::map<Record*, std::string> ids;
+  for (Record* rec : updated) {
+    const RField* id_field = rec->rkey.srcRField;
+    if (!id_field || id_field->is_null) {
+      throw std::runtime_error("Database ID for the record is not available via RKey.srcRField.");
+    }
+    ids[rec] = std::string(id_field->val);
+  }
+
+  // Деталь посилається на майстра через RField::link -> RKey::srcRField - поле id майстра
+  std::map<const RField*, Record*> new_by_id;
+  for (Record* rec : pending) {
+    if (rec->rkey.srcRField) new_by_id[rec->rkey.srcRField] = rec;
+  }
+  std::set<const Record*> unsaved(pending.begin(), pending.end());
+  auto master_of = [&](const RField& rf) -> Record* {
+    if (!rf.link) return nullptr;
+    auto it = new_by_id.find(rf.link->srcRField);
+    return it == new_by_id.end() ? nullptr : it->second;
+  };
+
+  // FK деталей, заповнені id ще не підтверджених майстрів; відновлюються, якщо пакет не збережено
+  struct LinkBackup {
+    RField* rf;
+    std::optional<std::string> value;
+    bool modified;
+  };
+  std::vector<LinkBackup> resolved_links;
+
+  std::optional<TransactionGuard> tx;
+  if (!db->inTransaction()) tx.emplace(*db);
+
+  std::vector<Record*> inserted;
+  std::vector<SqlDB::Statement> batch;
+  std::vector<std::unique_ptr<SqlDB::Result>> reloaded;
+  std::map<std::pair<const QModel*, std::vector<const QField*>>, std::vector<Record*>> reload_groups;
+  try {
+    // 2. Хвилями: INSERT записів, що не чекають id нових майстрів пакета, разом з усіма UPDATE -
+    // один обмін; кожен наступний рівень деталей - ще один.
+    while (!sqls.empty() || !pending.empty()) {
+      std::map<std::pair<const QModel*, std::string>, std::vector<Record*>> insert_groups;
+      std::vector<Record*> waiting;
+      for (Record* rec : pending) {
+        const bool waits = std::ranges::any_of(rec->rfields.all(), [&](const RField& rf) {
+          Record* master = master_of(rf);
+          return master && master != rec && unsaved.count(master);
+        });
+        if (waits) {
+          waiting.push_back(rec);
+          continue;
+        }
+        for (RField& rf : rec->rfields.all()) {
+          Record* master = master_of(rf);
+          auto id = master ? ids.find(master) : ids.end();
+          if (id == ids.end()) continue;
+          resolved_links.push_back({&rf, rf.is_null ? std::nullopt : std::optional<std::string>(rf.val), rf.is_modified});
+          rf.modify(id->second);
+        }
+        unsaved.erase(rec);
+        std::string columns = SqlGenius(rec).insert_columns();
+        if (!columns.empty()) insert_groups[{rec->rkey.tgtQModel, std::move(columns)}].push_back(rec);
+      }
+      if (sqls.empty() && insert_groups.empty() && waiting.size() == pending.size()) {
+        throw std::runtime_error("New records of the batch reference each other in a cycle.");
+      }
+      pending = std::move(waiting);
+
+      const size_t update_count = sqls.size();
+      for (const auto& [key, group] : insert_groups) {
+        SqlGenius genius(group.front());
+        sqls.push_back(genius.gen_insert_rows(group));
+        params.push_back(genius.takeParams());
+      }
+      if (sqls.empty()) continue;
+
+      batch.clear();
+      for (size_t i = 0; i < sqls.size(); ++i) {
+        // Текст INSERT залежить від кількості рядків - не кешуємо
+        batch.push_back({sqls[i], std::move(params[i]), i >= update_count});
+      }
+      auto results = db->query_pipeline(batch);
+
+      for (size_t i = 0; i < update_count; ++i) {
+        if (!results[i] || results[i]->row_count() == 0) throw std::runtime_error("Record to update was not found.");
+      }
+      size_t r = update_count;
+      for (const auto& [key, group] : insert_groups) {
+        const auto& res = results[r++];
+        if (!res || res->row_count() != static_cast<int>(group.size())) {
+          throw std::runtime_error("Failed to retrieve new IDs after INSERT.");
+        }
+        for (size_t row = 0; row < group.size(); ++row) {
+          ids[group[row]] = std::string(res->get_value(row, 0).value_or(""));
+          inserted.push_back(group[row]);
+        }
+      }
+      sqls.clear();
+      params.clear();
+    }
+
+    // 3. <<<<<<<<<<<<< Read-after-Write >>>>>>>>>>>>>
+    // Один запит на групу записів з однаковою QModel та набором видимих полів
+    for (const auto& [rec, id] : ids) {
+      if (rec->visible_fields.empty()) continue;
+      std::vector<const QField*> shape;
+      for (const RField* rf : rec->visible_fields) shape.push_back(&rf->qfield);
+      reload_groups[{rec->rkey.tgtQModel, std::move(shape)}].push_back(rec);
+    }
+    batch.clear();
+    sqls.reserve(reload_groups.size());  // batch тримає string_view на sqls
+    for (const auto& [key, group] : reload_groups) {
+      std::vector<std::string> group_ids;
+      for (Record* rec : group) group_ids.push_back(ids[rec]);
+      SqlGenius genius(group.front());
+      sqls.push_back(genius.gen_reload_by_ids(group.front()->visible_fields, group_ids));
+      // Текст сталий для групи завдяки = ANY($1::int[]) - готується і кешується
+      batch.push_back({sqls.back(), genius.takeParams()});
+    }
+    if (!batch.empty()) reloaded = db->query_pipeline(batch);
+
+    if (tx) tx->commit();
+  } catch (...) {
+    for (auto it = resolved_links.rbegin(); it != resolved_links.rend(); ++it) {
+      it->rf->modify(it->value ? optsv(*it->value) : std::nullopt);
+      it->rf->is_modified = it->modified;
+    }
+    throw;
+  }
+
+  // 4. Транзакція підтверджена - оновлюємо записи
+  for (Record* rec : inserted) {
+    rec->rkey.srcRField->setId(ids[rec]);
+    rec->is_new = false;
+  }
+  size_t g = 0;
+  for (const auto& [key, group] : reload_groups) {
+    std::shared_ptr<SqlDB::Result> res = std::move(reloaded[g++]);
+    std::map<sv, int> rows;
+    for (int row = 0; row < res->row_count(); ++row) rows[res->get_value(row, 0).value_or("")] = row;
+    for (Record* rec : group) {
+      auto it = rows.find(ids[rec]);
+      if (it != rows.end()) rec->applyRow(rec->visible_fields, res, it->second, 1);
+    }
+  }
+  for (const auto& [rec, id] : ids) rec->onSaved();
 }
+
 void Record::Delete() {
   if (is_new) {
     // Не можна видалити те, чого немає в БД
@@ -199,7 +412,7 @@ void Record::Delete() {
 
   SqlGenius genius(this);
   std::string sql = genius.gen_delete();  //
-  auto params = genius.getOrderedParams(sql);
+  auto params = genius.takeParams();
 
   Rack::get().sqldb->execute(sql, params);
 
@@ -238,64 +451,133 @@ Recordset::Recordset(const QModel& qmodel, const RKey& parentRKey, sv refFieldNa
 
 // rec.cpp
 
-void Recordset::doLoad(const vector_prf& fields_to_load) {
-  SqlGenius genius(this);
-  auto& db = Rack::get().sqldb;
+namespace {
 
-  // --- КРОК 1: Завжди отримуємо актуальну загальну кількість записів ---
-  if (!countSqlCache) {
-    // Генеруємо SQL для COUNT, тільки якщо він не був кешований
-    countSqlCache = genius.gen_select_count();
+/// Ключ актуальності total_count: текст COUNT і значення його параметрів.
+std::string count_signature(const std::string& sql, const std::vector<std::string>& params) {
+  std::string signature = sql;
+  for (const auto& p : params) {
+    signature += '\0';
+    signature += p;
   }
+  return signature;
+}
 
-  if (countSqlCache && !countSqlCache->empty()) {
-    auto count_params = genius.getOrderedParams(*countSqlCache);
-    std::unique_ptr<SqlDB::Result> count_res = db->query(*countSqlCache, count_params);
-    if (count_res && count_res->row_count() > 0) {
-      this->total_count = std::stoi(std::string(count_res->get_value(0, 0).value()));
-    } else {
-      this->total_count = 0;
-    }
+/// Оцінка кількості рядків з першого рядка EXPLAIN: "... (cost=0.00..18.50 rows=850 width=4)".
+uint32_t explain_rows(const SqlDB::Result& res) {
+  if (res.row_count() == 0) return 0;
+  sv line = res.get_text(0, 0).value_or("");
+  auto pos = line.find("rows=");
+  if (pos == sv::npos) return 0;
+  uint64_t rows = 0;
+  std::from_chars(line.data() + pos + 5, line.data() + line.size(), rows);
+  return static_cast<uint32_t>(std::min<uint64_t>(rows, UINT32_MAX));
+}
+
+/// Ключ сторінки в кеші prefetch: тексти і параметри запитів batch, починаючи з first.
+std::string page_signature(const std::vector<SqlDB::Statement>& batch, size_t first) {
+  std::string signature;
+  for (size_t i = first; i < batch.size(); ++i) {
+    signature += count_signature(std::string(batch[i].sql), batch[i].params);
+    signature += '\1';
   }
+  return signature;
+}
 
-  // --- КРОК 2: Завантажуємо ID для поточної сторінки (лише за потреби) ---
-  if (!pageCursorIds) {
-    if (!idsSqlCache) {
-      // Генеруємо SQL для SELECT id, тільки якщо він не був кешований
-      idsSqlCache = genius.gen_select_ids();
-    }
+}  // namespace
+
+std::vector<SqlDB::Statement> Recordset::buildLoadBatch(SqlGenius& genius, const vector_prf& fields_to_load,
+                                                       std::vector<std::string>& sqls) {
+  // Кожен gen_* дає свої параметри $1..$n; тексти COUNT та сторінки береже кеш форм SqlGenius.
+  // Сторінка сама повертає свої id і ключі сортування, тож пакет - COUNT і один SELECT.
+  sqls.clear();
+  sqls.reserve(2);  // batch тримає string_view на sqls
+  std::vector<SqlDB::Statement> batch;
+
+  // Крок 1 - за CountMode: крім EXACT, COUNT не повторюється, доки не змінились фільтри чи їх значення
+  std::string count_sql = genius.gen_select_count();
+  auto count_params = genius.takeParams();
+  std::string signature = count_signature(count_sql, count_params);
+  if (countMode != CountMode::EXACT && signature == countSignature) {
+    countStep = CountStep::NONE;
+  } else if (countMode == CountMode::ESTIMATE || countMode == CountMode::ASYNC) {
+    countStep = CountStep::ESTIMATE;
+  } else {
+    countStep = CountStep::EXACT;
+  }
+  if (countMode == CountMode::ASYNC && countStep == CountStep::ESTIMATE) {
+    // Точний COUNT - окремим запитом на іншому з'єднанні, сторінка його не чекає
+    pendingCount = Rack::get().sqldb->query_async(count_sql, count_params);
+    pendingSignature = signature;
+  }
+  countSignature = std::move(signature);
+
+  if (countStep == CountStep::EXACT) {
+    sqls.push_back(std::move(count_sql));
+    batch.push_back({sqls.back(), std::move(count_params), false, true});
+  } else if (countStep == CountStep::ESTIMATE) {
+    sqls.push_back(genius.gen_estimate_count());
+    batch.push_back({sqls.back(), genius.takeParams(), true});
+  }
 
-    // Ініціалізуємо вектор, навіть якщо запит нічого не поверне
-    pageCursorIds.emplace();
+  // Всі кроки йдуть одним пакетом: один обмін з сервером на одному з'єднанні.
+  appendPageBatch(genius, fields_to_load, sqls, batch);
+  return batch;
+}
 
-    if (idsSqlCache && !idsSqlCache->empty()) {
-      auto ids_params = genius.getOrderedParams(*idsSqlCache);
-      std::unique_ptr<SqlDB::Result> ids_res = db->query(*idsSqlCache, ids_params);
+void Recordset::appendPageBatch(SqlGenius& genius, const vector_prf& fields_to_load, std::vector<std::string>& sqls,
+                                std::vector<SqlDB::Statement>& batch) {
+  // Текст запиту сторінки не залежить від значень фільтрів і межі, тому він підготовлюється і кешується.
+  sqls.push_back(genius.gen_select_page(fields_to_load));
+  batch.push_back({sqls.back(), genius.takeParams()});
+}
 
-      if (ids_res && ids_res->row_count() > 0) {
-        pageCursorIds->reserve(ids_res->row_count());
-        for (int i = 0; i < ids_res->row_count(); ++i) {
-          // **ВИПРАВЛЕНО:** Тепер `pageCursorIds` є `vector<string>`, тому `stoi` не потрібен.
-          pageCursorIds->push_back(std::string(ids_res->get_value(i, 0).value()));
-        }
-      }
+void Recordset::applyLoadBatch(const vector_prf& fields_to_load, std::vector<std::unique_ptr<SqlDB::Result>> results) {
+  // --- КРОК 1: Загальна кількість записів (якщо була в пакеті) ---
+  size_t next_res = 0;
+  if (countStep != CountStep::NONE) {
+    const auto& count_res = results[next_res++];
+    if (!count_res || count_res->row_count() == 0) {
+      this->total_count = 0;
+    } else if (countStep == CountStep::EXACT) {
+      this->total_count = static_cast<uint32_t>(count_res->get_int64(0, 0).value_or(0));
+    } else {
+      this->total_count = explain_rows(*count_res);
     }
+    this->total_exact = countStep == CountStep::EXACT;
   }
 
-  // --- КРОК 3: Завантажуємо повні дані для ID поточної сторінки ---
-
-  // Очищуємо старий тимчасовий результат
+  // --- КРОК 2: Сторінка - поля, за ними id і ключі сортування (SqlGenius::gen_select_page) ---
   res.reset();
+  stream.reset();
+  dataset.reset();
+  auto& page_res = results[next_res];
+  const int id_col = static_cast<int>(fields_to_load.size());
+  pageCursorIds.emplace();
+  if (page_res && page_res->row_count() > 0) {
+    pageCursorIds->reserve(page_res->row_count());
+    for (int i = 0; i < page_res->row_count(); ++i) {
+      pageCursorIds->push_back(std::string(page_res->get_text(i, id_col).value()));
+    }
+  }
 
-  if (pageCursorIds && !pageCursorIds->empty()) {
-    // **ВИПРАВЛЕНО:** Конвертація ID в рядки більше не потрібна.
-    std::string data_sql = genius.gen_select_by_ids(fields_to_load, *pageCursorIds);
-
-    if (!data_sql.empty()) {
-      auto data_params = genius.getOrderedParams(data_sql);
-      // Використовуємо query_once, щоб не засмічувати кеш
-      res = db->query_once(data_sql, data_params);
+  // Межі сторінки для NextPage/PrevPage: поля сортування, далі id.
+  auto row_key = [&](int row) {
+    std::vector<string> key;
+    for (int col = id_col + 1; col < page_res->column_count(); ++col) {
+      auto v = page_res->get_text(row, col);
+      if (!v) return std::vector<string>{};  // NULL не порівнюється - лише OFFSET
+      key.emplace_back(*v);
     }
+    key.push_back((*pageCursorIds)[row]);
+    return key;
+  };
+  pageFirstKey.clear();
+  pageLastKey.clear();
+  if (!pageCursorIds->empty()) {
+    pageFirstKey = row_key(0);
+    pageLastKey = row_key(static_cast<int>(pageCursorIds->size()) - 1);
+    res = std::move(page_res);
   }
 
   // Зберігаємо список полів, з якими був зроблений запит, для методу next()
@@ -305,11 +587,116 @@ void Recordset::doLoad(const vector_prf& fields_to_load) {
   cursor_idx_for_next = -1;
 }
 
+void Recordset::doLoad(const vector_prf& fields_to_load) {
+  SqlGenius genius(this);
+  std::vector<std::string> sqls;
+  auto batch = buildLoadBatch(genius, fields_to_load, sqls);
+  std::vector<std::unique_ptr<SqlDB::Result>> results;
+  if (!takePrefetched(batch, results)) {
+    results = Rack::get().sqldb->query_pipeline(batch);
+  }
+  applyLoadBatch(fields_to_load, std::move(results));
+  prefetchAdjacent(fields_to_load);
+}
+
+bool Recordset::takePrefetched(const std::vector<SqlDB::Statement>& batch,
+                               std::vector<std::unique_ptr<SqlDB::Result>>& results) {
+  // Перед запитом сторінки в пакеті може бути крок 1 (COUNT)
+  const size_t first = countStep == CountStep::NONE ? 0 : 1;
+  auto it = prefetched.find(page_signature(batch, first));
+  if (it == prefetched.end()) return false;
+  PrefetchedPage pending = std::move(it->second);
+  prefetched.erase(it);
+  // COUNT, якого немає в prefetch (кроку 1 не чекали) - звичайне завантаження, теж один обмін
+  if (first && (countStep != CountStep::EXACT || !pending.with_count)) return false;
+
+  try {
+    results = pending.results.get();  // Якщо ще в польоті - чекаємо лише залишок
+  } catch (const std::exception&) {
+    return false;  // Невдалий prefetch - звичайне завантаження
+  }
+  // COUNT з пакета prefetch, що не потрібен цьому Load(), відкидаємо
+  if (pending.with_count && !first) results.erase(results.begin());
+  return true;
+}
+
+void Recordset::onSaved() {
+  countSignature.clear();  // Запис міг з'явитись у вибірці чи вийти з неї
+  prefetched.clear();      // Завантажені наперед сторінки - до збереження
+}
+
+void Recordset::prefetchAdjacent(const vector_prf& fields_to_load) {
+  decltype(prefetched) keep;
+  auto launch = [&](Seek dir) {
+    // SqlGenius бере стан сторінки з Recordset - тимчасово підставляємо сусідню
+    PageState current = swapPageState(adjacentPage(dir));
+    SqlGenius genius(this);
+    std::vector<std::string> sqls;
+    sqls.reserve(2);  // batch тримає string_view на sqls
+    std::vector<SqlDB::Statement> batch;
+    // EXACT рахує COUNT при кожному Load() - він іде тим самим пакетом, щоб сторінка з кешу не чекала БД
+    const bool with_count = countMode == CountMode::EXACT;
+    if (with_count) {
+      sqls.push_back(genius.gen_select_count());
+      batch.push_back({sqls.back(), genius.takeParams(), false, true});
+    }
+    appendPageBatch(genius, fields_to_load, sqls, batch);
+    swapPageState(std::move(current));
+
+    std::string signature = page_signature(batch, with_count ? 1 : 0);
+    auto it = prefetched.find(signature);
+    if (it != prefetched.end()) {
+      keep.insert(prefetched.extract(it));  // Вже завантажується
+    } else {
+      // query_pipeline_async копіює пакет, тож sqls може звільнитись одразу
+      keep.emplace(std::move(signature), PrefetchedPage{Rack::get().sqldb->query_pipeline_async(batch), with_count});
+    }
+  };
+  if (prefetch != Prefetch::NONE && pageCursorIds && pageCursorIds->size() >= pager.limit) {
+    launch(Seek::NEXT);  // Неповна сторінка - остання
+  }
+  if (prefetch == Prefetch::BOTH && pager.offset > 0) {
+    launch(Seek::PREV);
+  }
+  // Сторінки, що вже не сусідні, відкидаємо
+  prefetched = std::move(keep);
+}
+
 void Recordset::Load() {
   // Просто викликаємо захищений "робочий" метод з видимими полями
   doLoad(this->visible_fields);
 }
 
+std::future<void> Recordset::LoadAsync() {
+  const vector_prf fields_to_load = this->visible_fields;
+  SqlGenius genius(this);
+  std::vector<std::string> sqls;
+  auto batch = buildLoadBatch(genius, fields_to_load, sqls);
+  // query_pipeline_async копіює пакет, тож sqls може звільнитись одразу
+  auto pending = Rack::get().sqldb->query_pipeline_async(batch);
+  return std::async(std::launch::deferred, [this, fields_to_load, pending = std::move(pending)]() mutable {
+    applyLoadBatch(fields_to_load, pending.get());
+  });
+}
+
+void Recordset::LoadStream(uint32_t chunk_rows) {
+  res.reset();
+  stream.reset();  // Недочитаний попередній потік звільняє з'єднання
+  dataset.reset();
+
+  const vector_prf& fields_to_load = this->visible_fields;
+  SqlGenius genius(this);
+  std::string sql = genius.gen_select_all(fields_to_load);
+  if (!sql.empty()) {
+    auto params = genius.takeParams();
+    stream = Rack::get().sqldb->query_stream(sql, params, static_cast<int>(chunk_rows));
+    res = stream->next_chunk();
+  }
+
+  this->fields_in_last_query = fields_to_load;
+  cursor_idx_for_next = -1;
+}
+
 void Recordset::Delete() {
   std::vector<std::string> ids_to_delete;
 
@@ -334,8 +721,10 @@ void Recordset::Delete() {
   if (sql.empty()) return;
 
   // 3. Виконуємо запит
-  auto params = genius.getOrderedParams(sql);
+  auto params = genius.takeParams();
   Rack::get().sqldb->execute(sql, params);
+  countSignature.clear();  // Кількість змінилась і для CountMode, що її кешують
+  prefetched.clear();      // Завантажені наперед сторінки теж
 
   // 4. Після видалення обов'язково перезавантажуємо дані
   // щоб користувач побачив актуальний список.
@@ -348,6 +737,9 @@ void Recordset::SetFilter(RField& rfield, sv value) {
   // Перевірка, що поле належить цьому Recordset'у
   assert(rfield.owner == this && "Attempted to set a filter using an RField from a different owner!");
 
+  // Значення, що не відповідає типу поля, відхиляємо до зміни стану (кидає std::invalid_argument)
+  FilterParser{Filter{rfield, string(value)}};
+
   // Патерн "знайти та оновити, або додати новий"
   auto it = std::find_if(filters.begin(), filters.end(), [&](const Filter& f) { return &f.rfield == &rfield; });
 
@@ -359,10 +751,10 @@ void Recordset::SetFilter(RField& rfield, sv value) {
     filters.push_back({rfield, string(value)});
   }
 
-  // Зміна фільтра робить неактуальними і SQL, і список ID
-  countSqlCache.reset();
-  idsSqlCache.reset();
+  // Зміна фільтра робить неактуальними список ID, межі та завантажені наперед сторінки
   pageCursorIds.reset();
+  resetSeek();
+  prefetched.clear();
 
   // Завжди повертаємо користувача на першу сторінку після зміни фільтра
   pager.offset = 0;
@@ -375,24 +767,92 @@ void Recordset::SetSort(RField& rfield, Sort::Direction dir) {
   sorts.clear();
   sorts.push_back({rfield, dir});
 
-  // Зміна сортування робить неактуальними і SQL, і список ID
-  countSqlCache.reset();
-  idsSqlCache.reset();
+  // Зміна сортування робить неактуальними список ID, ключі меж та завантажені наперед сторінки
   pageCursorIds.reset();
+  resetSeek();
+  prefetched.clear();
 
   // Завжди повертаємо користувача на першу сторінку
   pager.offset = 0;
 }
 
 void Recordset::SetPage(Pager newPager) {
-  // Оновлюємо параметри пагінації
-  this->pager = newPager;
+  // Оновлюємо параметри пагінації; довільний перехід - лише через OFFSET
+  swapPageState({newPager, Seek::NONE, {}});
 
-  // SQL-запити залишаються валідними, але список ID для старої сторінки вже неактуальний.
+  // Список ID для старої сторінки вже неактуальний.
   // Скидаємо його, щоб при наступному Load() завантажились ID для нової сторінки.
   this->pageCursorIds.reset();
 }
 
+void Recordset::SetPrefetch(Prefetch mode) {
+  prefetch = mode;
+  if (prefetch == Prefetch::NONE) prefetched.clear();
+}
+
+void Recordset::SetCountMode(CountMode mode) {
+  countMode = mode;
+  countSignature.clear();  // Наступний Load() рахує за новою стратегією
+}
+
+Recordset::TotalCount Recordset::GetTotalCount() {
+  if (pendingCount.valid() && pendingCount.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+    auto count_res = pendingCount.get();
+    // Фільтри могли змінитись, поки COUNT рахувався - тоді він вже не про цей список
+    if (pendingSignature == countSignature && count_res && count_res->row_count() > 0) {
+      total_count = static_cast<uint32_t>(count_res->get_int64(0, 0).value_or(0));
+      total_exact = true;
+    }
+    pendingSignature.clear();
+  }
+  return {total_count, total_exact};
+}
+
+Recordset::PageState Recordset::adjacentPage(Seek dir) const {
+  PageState state{pager, Seek::NONE, {}};
+  if (dir == Seek::NEXT) {
+    state.pager.offset += pager.limit;  // Номер сторінки для відображення; запит його не використовує
+    // Межа невідома (ще не завантажено або NULL у полі сортування) - через OFFSET
+    if (!pageLastKey.empty()) {
+      state.seek = Seek::NEXT;
+      state.seekKey = pageLastKey;
+    }
+  } else {
+    state.pager.offset = pager.offset > pager.limit ? pager.offset - pager.limit : 0;
+    // Перша сторінка дешева і через OFFSET, а неповної "попередньої" не буде
+    if (state.pager.offset != 0 && !pageFirstKey.empty()) {
+      state.seek = Seek::PREV;
+      state.seekKey = pageFirstKey;
+    }
+  }
+  return state;
+}
+
+Recordset::PageState Recordset::swapPageState(PageState state) {
+  PageState previous{pager, seek, std::move(seekKey)};
+  pager = state.pager;
+  seek = state.seek;
+  seekKey = std::move(state.seekKey);
+  return previous;
+}
+
+void Recordset::NextPage() {
+  swapPageState(adjacentPage(Seek::NEXT));
+  pageCursorIds.reset();
+}
+
+void Recordset::PrevPage() {
+  swapPageState(adjacentPage(Seek::PREV));
+  pageCursorIds.reset();
+}
+
+void Recordset::resetSeek() {
+  seek = Seek::NONE;
+  seekKey.clear();
+  pageFirstKey.clear();
+  pageLastKey.clear();
+}
+
 // Реалізація AddSort, як обговорювалось
 void Recordset::AddSort(RField& rfield, Sort::Direction dir) {
   assert(rfield.owner == this && "Attempted to add a sort using an RField from a different owner!");
@@ -401,9 +861,9 @@ void Recordset::AddSort(RField& rfield, Sort::Direction dir) {
   sorts.push_back({rfield, dir});
 
   // Логіка аналогічна SetSort
-  countSqlCache.reset();
-  idsSqlCache.reset();
   pageCursorIds.reset();
+  resetSeek();
+  prefetched.clear();
   pager.offset = 0;
 }
 void Recordset::SetCurrentRow(uint32_t row_page_idx) {
@@ -433,6 +893,41 @@ void Recordset::ApplySelection() {
   }
 }
 
+Dataset::Dataset(const SqlDB::Result& res, int cols)
+    : rows(res.row_count()), cols(cols), mask_bytes((cols + 7) / 8) {
+  // Спершу розмір, щоб арена виділилась один раз
+  size_t total = 0;
+  for (int col = 0; col < cols; ++col) {
+    for (int row = 0; row < rows; ++row) total += res.get_value(row, col).value_or(sv{}).size();
+  }
+  if (total > std::numeric_limits<uint32_t>::max()) throw std::runtime_error("Dataset: page exceeds 4 GiB.");
+  arena.reserve(total);
+  offsets.resize(static_cast<size_t>(cols) * (rows + 1));
+  nulls.assign(static_cast<size_t>(rows) * mask_bytes, 0);
+
+  for (int col = 0; col < cols; ++col) {
+    uint32_t* off = offsets.data() + static_cast<size_t>(col) * (rows + 1);
+    for (int row = 0; row < rows; ++row) {
+      off[row] = static_cast<uint32_t>(arena.size());
+      optsv value = res.get_value(row, col);
+      if (value) {
+        arena.append(*value);
+      } else {
+        nulls[row * mask_bytes + col / 8] |= static_cast<uint8_t>(1u << (col % 8));
+      }
+    }
+    off[rows] = static_cast<uint32_t>(arena.size());
+  }
+}
+
+const Dataset* Recordset::GetDataset() {
+  if (!dataset) {
+    if (!res || stream) return nullptr;
+    dataset.emplace(*res, static_cast<int>(fields_in_last_query.size()));
+  }
+  return &*dataset;
+}
+
 bool Recordset::next() {
   if (!res) {
     return false;
@@ -440,18 +935,25 @@ bool Recordset::next() {
 
   cursor_idx_for_next++;
 
-  if (cursor_idx_for_next >= res->row_count()) {
+  while (cursor_idx_for_next >= res->row_count()) {
+    // У потоковому режимі замінюємо вичитану порцію наступною
+    if (stream && (res = stream->next_chunk())) {
+      cursor_idx_for_next = 0;
+      continue;
+    }
     res.reset();  // Звільняємо результат
+    stream.reset();
     cursor_idx_for_next = -1;
     return false;
   }
 
-  // 1. Перевірка на консистентність: кількість колонок у результаті
-  // має збігатися з кількістю полів, які ми запитували.
-  assert(res->column_count() == fields_in_last_query.size() && "Mismatch between data columns and RField pointers");
+  // 1. Перевірка на консистентність: перші колонки результату - поля, які ми запитували;
+  // за ними сторінка має ще id і ключі сортування.
+  const int field_count = static_cast<int>(fields_in_last_query.size());
+  assert(res->column_count() >= field_count && "Mismatch between data columns and RField pointers");
 
   // 2. Заповнюємо RFields, ітеруючи по колонках і вектору fields_in_last_query_ одночасно
-  for (int j = 0; j < res->column_count(); ++j) {
+  for (int j = 0; j < field_count; ++j) {
     // Отримуємо прямий вказівник на RField, який треба заповнити
     RField* rfield = fields_in_last_query[j];
 
@@ -1,7 +1,9 @@
 #pragma once
 // @preserve all comments
+#include <future>
 #include <map>
 #include <optional>
+#include <ranges>
 #include <string_view>
 #include <vector>
 
@@ -12,6 +14,7 @@ namespace ky {
 class RField;
 class Record;
 class Recordset;
+class SqlGenius;
 
 struct RKey {
   /// For Link
@@ -21,14 +24,14 @@ struct RKey {
   /// For Recordset
   RKey() = default;
 
-  RKey(const RField& src, QModel& tgt) : srcRField(&src), tgtQModel(&tgt) {}
+  RKey(const RField& src, const QModel& tgt) : srcRField(&src), tgtQModel(&tgt) {}
 };
 
 struct RField {
   const Record* owner;
   roid_t roid;
   const QField& qfield;
-  std::unique_ptr<RKey> rkey{nullptr};  /// Для FK-зв'язку "один-до-одного"
+  std::optional<RKey> rkey;          /// Для FK-зв'язку "один-до-одного"
   const RKey* link = nullptr;                 /// Для зв'язку "один-до-багатьох"
 
   bool aux = false;  /// auxiliary переважно для зберігання id та *_id полів
@@ -38,6 +41,8 @@ struct RField {
   void set(optsv from_db);
   void modify(optsv from_client);
   void setId(sv new_id) const;
+  /// Копіює значення з результату запиту у власний буфер, щоб результат можна було звільнити.
+  void own();
   void flush();
   explicit RField(const Record* owner, const QField& qfield) : owner(owner), qfield(qfield){};
 
@@ -45,6 +50,28 @@ private:
   mutable std::string mval;
 };
 
+/**
+ * @brief Арена RField одного запису.
+ * @details Поля лежать підряд у блоках; блок резервується одразу на всі відомі слоти моделі,
+ * наступні блоки - удвічі більші. Блок ніколи не переалоковується, тож адреси RField стабільні
+ * (на них посилаються RKey, слоти та fields_in_last_query).
+ */
+class RFieldArena {
+  std::vector<std::vector<RField>> blocks;
+
+public:
+  RField& emplace(size_t hint, const Record* owner, const QField& qfield) {
+    if (blocks.empty() || blocks.back().size() == blocks.back().capacity()) {
+      size_t cap = blocks.empty() ? std::max<size_t>(hint, 8) : blocks.back().capacity() * 2;
+      blocks.emplace_back().reserve(cap);
+    }
+    return blocks.back().emplace_back(owner, qfield);
+  }
+  /// Усі поля в порядку створення.
+  auto all() { return blocks | std::views::join; }
+  auto all() const { return blocks | std::views::join; }
+};
+
 class Record {
   roid_t roid;
 
@@ -55,13 +82,26 @@ public:
 
   const RKey& rkey;
 private:
-  using RFields = std::vector<std::unique_ptr<RField>>;
-  RFields rfields;
+  RFieldArena rfields;
+  /// RField за QField::slot; nullptr - поле в цьому записі ще не створене.
+  std::vector<RField*> slots;
   bool is_new;
 
+  // Дані, на які дивляться RField::val після Load(); після SaveBatch() - спільні для записів пакета
+  std::shared_ptr<SqlDB::Result> loaded_res;
+
 protected:
   vector_prf visible_fields;
   void doLoad(const vector_prf& fields_to_load);
+  void applyLoad(const vector_prf& fields_to_load, std::unique_ptr<SqlDB::Result> res);
+  /// Заповнює поля з рядка row результату, починаючи з колонки first_col.
+  void applyRow(const vector_prf& fields_to_load, std::shared_ptr<SqlDB::Result> res, int row, int first_col);
+  /// Звільняє loaded_res; поля, яких немає в reloaded, перед тим забирають свої значення (RField::own).
+  void releaseLoaded(const vector_prf& reloaded);
+  /// Застосовує результат SqlGenius::gen_save(): id нового запису та перечитані поля.
+  void applySave(const vector_prf& fields_to_load, std::unique_ptr<SqlDB::Result> res);
+  /// Після успішного Save()/SaveAsync()/SaveBatch() цього запису; Recordset скидає кеші сторінок.
+  virtual void onSaved() {}
 
 public:
   void* dto = nullptr;
@@ -72,7 +112,7 @@ public:
 
   /**
    * @brief Знаходить існуючий RField за прямими вказівниками на QTable та Field.
-   * @details Цей метод виконує лише пошук серед вже ініціалізованих полів.
+   * @details Цей метод виконує лише пошук серед вже ініціалізованих полів (за слотом, O(1)).
    * Він не створює новий RField, якщо його не знайдено.
    * @param pqt Вказівник на кваліфіковану таблицю (QTable).
    * @param pf Вказівник на метадані поля (Field).
@@ -84,6 +124,27 @@ public:
   void Load();
   void Refresh();
   void Save();
+
+  /**
+   * @brief Асинхронні варіанти Load() та Save().
+   * @details Запит відправляється одразу і не блокує потік. Поля запису заповнюються
+   * в потоці, що викличе get()/wait() на повернутому future (std::launch::deferred),
+   * бо Record не потокобезпечний. Помилки БД кидаються з get().
+   */
+  std::future<void> LoadAsync();
+  std::future<void> SaveAsync();
+
+  /**
+   * @brief Зберігає кілька записів в одній транзакції.
+   * @details Нові записи однієї QModel з однаковим набором змінених полів вставляються
+   * одним INSERT ... RETURNING id, усі INSERT та UPDATE відправляються одним пакетом
+   * (SqlDB::query_pipeline). Read-after-Write - один запит на кожну QModel пакета.
+   * Якщо транзакція вже відкрита в цьому потоці, записи зберігаються в ній.
+   * Нова деталь нового майстра (RField::link) вставляється наступною хвилею з id майстра;
+   * кожен рівень вкладеності - ще один обмін. UPDATE, що не знайшов запису, кидає виняток, як Save().
+   * Поля записів оновлюються лише після успішного COMMIT; FK деталей при помилці відновлюються.
+   */
+  static void SaveBatch(const std::vector<Record*>& records);
   void Delete();
   void Undo();
   void SetVisibleFields(const vector_prf& fields);
@@ -91,6 +152,46 @@ public:
   virtual ~Record() = default;
 };
 
+/**
+ * @brief Завантажена сторінка колонками - Dataset з doc/RecordsetHybrid.md для read-only списків.
+ * @details Значення кожної колонки лежать підряд в одній арені байтів, межі значень - у зміщеннях
+ * (rows + 1 на колонку), NULL - біти маски рядка. Серіалізація сторінки клієнту - лінійне
+ * копіювання, без RField::set для кожної комірки.
+ */
+class Dataset {
+public:
+  /// @param cols Колонки даних - перші cols колонок res; id і ключі сторінки за ними не копіюються.
+  Dataset(const SqlDB::Result& res, int cols);
+
+  int row_count() const { return rows; }
+  int column_count() const { return cols; }
+
+  bool is_null(int row, int col) const { return nulls[row * mask_bytes + col / 8] & (1u << (col % 8)); }
+  optsv get_value(int row, int col) const {
+    if (is_null(row, col)) return std::nullopt;
+    const uint32_t* off = column_offsets(col);
+    return sv(arena.data() + off[row], off[row + 1] - off[row]);
+  }
+
+  /// Байти всієї колонки підряд; межі значень - column_offsets(col), абсолютні в арені.
+  sv column_bytes(int col) const {
+    const uint32_t* off = column_offsets(col);
+    return sv(arena.data() + off[0], off[rows] - off[0]);
+  }
+  const uint32_t* column_offsets(int col) const { return offsets.data() + static_cast<size_t>(col) * (rows + 1); }
+
+  /// Маска NULL рядка, як Dataset.Row.null_mask: біт col у байті col / 8.
+  sv null_mask(int row) const { return sv(reinterpret_cast<const char*>(nulls.data()) + row * mask_bytes, mask_bytes); }
+
+private:
+  int rows;
+  int cols;
+  int mask_bytes;
+  std::string arena;  // колонки одна за одною
+  std::vector<uint32_t> offsets;
+  std::vector<uint8_t> nulls;
+};
+
 class Recordset : public Record {
 public:
   struct Filter {
@@ -108,6 +209,26 @@ public:
     uint32_t offset = 0;
     uint32_t limit = 30;  // Типовий розмір сторінки
   };
+
+  /// Стратегія підрахунку total_count при Load(); атрибут списку count(...) у layout.
+  enum class CountMode {
+    EXACT,     ///< exact: COUNT за фільтрами при кожному Load()
+    CACHED,    ///< cached: точний COUNT один раз на набір фільтрів і їх значень
+    ESTIMATE,  ///< estimate: оцінка планувальника (EXPLAIN rows) один раз на набір фільтрів
+    ASYNC      ///< async: спершу оцінка, точний COUNT рахується окремо і з'являється пізніше
+  };
+
+  /// Фонове завантаження сусідніх сторінок після Load(); атрибут списку prefetch(...) у layout.
+  enum class Prefetch {
+    NONE,  ///< none: без попереднього завантаження
+    NEXT,  ///< next: наступна сторінка
+    BOTH   ///< both: наступна і попередня
+  };
+
+  struct TotalCount {
+    uint32_t count = 0;
+    bool exact = true;  ///< false - оцінка планувальника
+  };
   using URecord = std::unique_ptr<Record>;
 
 private:
@@ -118,28 +239,76 @@ private:
 
   std::unordered_set<string> selected_record_ids;  // DB id of selected records
   uint32_t total_count = 0;
+  bool total_exact = true;
 
-  // Кеші для SQL запитів, що не залежать від сторінки
-  std::optional<std::string> countSqlCache;
-  std::optional<std::string> idsSqlCache;
+  // Підрахунок total_count (CountMode)
+  enum class CountStep { NONE, EXACT, ESTIMATE };
+  CountMode countMode = CountMode::EXACT;
+  CountStep countStep = CountStep::NONE;  // що buildLoadBatch поклав першим у пакет
+  std::string countSignature;  // COUNT з параметрами, для якого total_count актуальний
+  std::string pendingSignature;  // ASYNC: COUNT з параметрами, що рахується в pendingCount
+  std::future<std::unique_ptr<SqlDB::Result>> pendingCount;
 
   // Кеш ID записів для поточної завантаженої сторінки
   std::optional<std::vector<string>> pageCursorIds;
 
+  // Prefetch: запити сусідніх сторінок, що виконуються на іншому з'єднанні пулу.
+  // Ключ - тексти і параметри цих запитів (page_signature), тож сторінка береться з кешу
+  // лише для того самого стану pager, keyset-межі, фільтрів і полів.
+  struct PrefetchedPage {
+    std::future<std::vector<std::unique_ptr<SqlDB::Result>>> results;
+    bool with_count = false;  // першим у пакеті - COUNT (CountMode::EXACT)
+  };
+  Prefetch prefetch = Prefetch::NONE;
+  std::map<std::string, PrefetchedPage> prefetched;
+
   // Params
   std::vector<Filter> filters;
   std::vector<Sort> sorts;
   Pager pager;
   // ***
 
+  // Keyset-пагінація: наступна/попередня сторінка шукається від межі завантаженої,
+  // а не через OFFSET. Ключ - значення полів сортування (як текст) і id.
+  enum class Seek { NONE, NEXT, PREV };
+  Seek seek = Seek::NONE;  // NONE - LIMIT/OFFSET за pager
+  std::vector<string> seekKey;  // межа, від якої шукає seek
+  std::vector<string> pageFirstKey, pageLastKey;  // межі завантаженої сторінки; порожні - невідомі
+  bool seeking() const { return seek != Seek::NONE && !seekKey.empty(); }
+  void resetSeek();
+
+  /// Стан, що визначає запити сторінки: pager та keyset-межа.
+  struct PageState {
+    Pager pager;
+    Seek seek = Seek::NONE;
+    std::vector<string> seekKey;
+  };
+  /// Стан сусідньої сторінки (NEXT/PREV) від завантаженої, як його встановлять NextPage()/PrevPage().
+  PageState adjacentPage(Seek dir) const;
+  /// Встановлює стан сторінки і повертає попередній; pageCursorIds не чіпає.
+  PageState swapPageState(PageState state);
+
   // Зберігає список полів, що використовувались в останньому запиті Load().
   // Це потрібно для коректної роботи методу next().
   // (Пропозиція: перейменувати на lastQueryFields для ясності)
   vector_prf fields_in_last_query;
   std::unique_ptr<SqlDB::Result> res;  // Зберігає результат запиту для ітерації курсором
+  std::unique_ptr<SqlDB::Stream> stream;  // Джерело наступних порцій res у потоковому режимі
   int cursor_idx_for_next = -1;  // Індекс поточного рядка курсора (-1 = перед першим)
+  std::optional<Dataset> dataset;  // res сторінки колонками, будується на вимогу GetDataset()
 
   void doLoad(const vector_prf& fields_to_load);
+  std::vector<SqlDB::Statement> buildLoadBatch(SqlGenius& genius, const vector_prf& fields_to_load,
+                                               std::vector<std::string>& sqls);
+  void applyLoadBatch(const vector_prf& fields_to_load, std::vector<std::unique_ptr<SqlDB::Result>> results);
+  /// Запит сторінки (крок 2) у batch; sqls має мати резерв під нього.
+  void appendPageBatch(SqlGenius& genius, const vector_prf& fields_to_load, std::vector<std::string>& sqls,
+                       std::vector<SqlDB::Statement>& batch);
+  /// Результати пакета, якщо його сторінка вже завантажена prefetch; інакше false.
+  bool takePrefetched(const std::vector<SqlDB::Statement>& batch, std::vector<std::unique_ptr<SqlDB::Result>>& results);
+  /// Запускає завантаження сусідніх сторінок за режимом prefetch.
+  void prefetchAdjacent(const vector_prf& fields_to_load);
+  void onSaved() override;
 
 public:
   Recordset(const QModel& qmodel);
@@ -166,17 +335,50 @@ public:
 //  const RKey& getRKey() const;
 
   void Load();
+  /// Асинхронний Load(): дивись Record::LoadAsync().
+  std::future<void> LoadAsync();
+
+  /**
+   * @brief Потоковий режим: всі рядки за фільтрами та сортуванням, без сторінок.
+   * @details next() читає рядки порціями до chunk_rows, тому пам'ять не залежить
+   * від кількості рядків (експорт, звіти). total_count та id сторінки не змінюються.
+   * @param chunk_rows Максимальна кількість рядків в одній порції.
+   */
+  void LoadStream(uint32_t chunk_rows = 1000);
   void Delete();
   void SetFilter(RField& rfield, const sv value);
   void SetSort(RField& rfield, Sort::Direction dir);
   void AddSort(RField& rfield, Sort::Direction dir);
   void SetPage(Pager pager);
+
+  void SetCountMode(CountMode mode);
+
+  /**
+   * @brief Вмикає фонове завантаження сусідніх сторінок.
+   * @details Після кожного Load() id і дані наступної (і, для BOTH, попередньої) сторінки
+   * запитуються на іншому з'єднанні пулу. NextPage()/PrevPage() чи SetPage() на таку сторінку
+   * і Load() беруть її з кешу без очікування БД. SetFilter/SetSort/AddSort/Delete кеш скидають.
+   * У CountMode::EXACT COUNT іде в тому ж пакеті prefetch, тож сторінка з кешу приносить і
+   * total_count на момент свого завантаження.
+   */
+  void SetPrefetch(Prefetch mode);
+  /// Кількість записів за фільтрами. Для CountMode::ASYNC забирає точний COUNT, якщо він вже готовий.
+  TotalCount GetTotalCount();
+
+  /// Наступна/попередня сторінка через keyset: WHERE (поля сортування, id) > межа сторінки.
+  /// Як і SetPage, лише готує стан для Load(). SetPage лишається для довільних переходів.
+  void NextPage();
+  void PrevPage();
   void SetCurrentRow(uint32_t row_page_idx);
 
   // Метод для застосування вибору і повернення значення
   void ApplySelection();
 
   bool next();
+
+  /// Завантажена сторінка колонками для read-only списків, без переписування RField.
+  /// nullptr - сторінки немає: Load() не було, рядки вже вичитані next() або потоковий режим.
+  const Dataset* GetDataset();
   friend class SqlGenius;
 };
 
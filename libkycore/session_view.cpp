@@ -51,6 +51,8 @@ private:
         const QModel& qmodel = *rack.qmodels[table];
         new_rec = new Recordset(qmodel);
       }
+      static_cast<Recordset*>(new_rec)->SetCountMode(count_mode(get_default(list_node->attrs, "count", "exact")));
+      static_cast<Recordset*>(new_rec)->SetPrefetch(prefetch_mode(get_default(list_node->attrs, "prefetch", "none")));
     }
     if(new_rec !=nullptr){
       view->records.emplace(rack.ruid32(), contextRecord = new_rec);
@@ -65,6 +67,27 @@ private:
 
   void create_records_recursive(const LayoutNode* node);
 
+  /// Атрибут списку count(exact|cached|estimate|async) - стратегія total_count.
+  static Recordset::CountMode count_mode(const string& name) {
+    if (name == "cached") return Recordset::CountMode::CACHED;
+    if (name == "estimate") return Recordset::CountMode::ESTIMATE;
+    if (name == "async") return Recordset::CountMode::ASYNC;
+    if (name != "exact") {
+      std::cerr << "Warning: Unknown count mode '" << name << "', using 'exact'." << std::endl;
+    }
+    return Recordset::CountMode::EXACT;
+  }
+
+  /// Атрибут списку prefetch(none|next|both) - фонове завантаження сусідніх сторінок.
+  static Recordset::Prefetch prefetch_mode(const string& name) {
+    if (name == "next") return Recordset::Prefetch::NEXT;
+    if (name == "both") return Recordset::Prefetch::BOTH;
+    if (name != "none") {
+      std::cerr << "Warning: Unknown prefetch mode '" << name << "', using 'none'." << std::endl;
+    }
+    return Recordset::Prefetch::NONE;
+  }
+
   View* view = nullptr;  // Вказівник на View, який ми "будуємо"
   const RKey* rkey = nullptr;
   Record* contextRecord = nullptr;
@@ -1,5 +1,4 @@
 #pragma once
-#if 0 // TODO later
 #include "rack.h" // Для доступу до SqlDB
 #include <iostream>
 
@@ -11,6 +10,7 @@ namespace ky {
  *
  * Автоматично починає транзакцію при створенні і відкочує її при знищенні,
  * якщо вона не була явно підтверджена за допомогою методу commit().
+ * Транзакція належить потоку, що створив guard (див. SqlDB::beginTransaction()).
  *
  * Приклад використання:
  * @code
@@ -39,10 +39,15 @@ public:
      * @brief Деструктор.
      *
      * Якщо транзакція не була підтверджена через commit(), викликає rollback().
+     * Деструктор працює і під час розкрутки стеку, тому помилку rollback() лише логуємо.
      */
     ~TransactionGuard() noexcept {
         if (!committed_) {
-            db_.rollback();
+            try {
+                db_.rollback();
+            } catch (const std::exception& e) {
+                std::cerr << "TransactionGuard: rollback failed: " << e.what() << std::endl;
+            }
         }
     }
 
@@ -59,8 +64,9 @@ public:
      * відкотити транзакцію.
      */
     void commit() {
-        db_.commit();
+        // Транзакція завершена навіть якщо COMMIT кинув виняток - повторний rollback() не потрібен
         committed_ = true;
+        db_.commit();
     }
 
 private:
@@ -68,4 +74,3 @@ private:
     bool committed_;
 };
 } // namespace ky
-#endif
\ No newline at end of file
@@ -16,6 +16,15 @@ struct type_t::Hidden {
   virtual bool validate([[maybe_unused]] sv val) const { return false; }
   virtual const string sql() const = 0;
   virtual const string sqlSufix() const { return ""; };
+  virtual type_t::bin_t bin() const { return type_t::bin_t::none; }
+
+  // Порожнє значення - NULL, його перевіряє не тип, а обмеження колонки.
+  static bool validate_int32(sv val, int32_t min) {
+    if (val.empty()) return true;
+    int32_t num;
+    auto [ptr, ec] = std::from_chars(val.data(), val.data() + val.size(), num);
+    return ec == std::errc() && ptr == val.data() + val.size() && num >= min;
+  }
 
   static sv get_base_type(sv type_str) {
     size_t pos = type_str.find('(');
@@ -28,6 +37,8 @@ struct type_t::Hidden {
 // --- Конкретні реалізації ---
 struct type_id_t : base_t {
   const string sql() const override { return "serial PRIMARY KEY"; };
+  type_t::bin_t bin() const override { return type_t::bin_t::int32; }
+  bool validate(sv val) const override { return validate_int32(val, 1); }
 };
 
 struct type_ref_t : base_t {
@@ -38,6 +49,8 @@ struct type_ref_t : base_t {
     return "INT"; /* або реалізація FOREIGN KEY */
   }
   const string sqlSufix() const override { return "_id"; }
+  type_t::bin_t bin() const override { return type_t::bin_t::int32; }
+  bool validate(sv val) const override { return validate_int32(val, 1); }
   const Table *ref() const override {
     assert(ref_table != nullptr);
     return ref_table;
@@ -50,18 +63,34 @@ struct type_varchar_t : base_t {
   const string sql() const override {
     return maxlen > 0 ? "varchar(" + std::to_string(maxlen) + ")" : "varchar";
   }
+  type_t::bin_t bin() const override { return type_t::bin_t::text; }
+  bool validate(sv val) const override {
+    if (maxlen == 0 || val.size() <= maxlen) return true;
+    // varchar(n) у PostgreSQL рахує символи, а не байти UTF-8
+    size_t chars = 0;
+    for (unsigned char c : val) {
+      if ((c & 0xC0) != 0x80) ++chars;
+    }
+    return chars <= maxlen;
+  }
 };
 
 struct type_int_t : base_t {
   const string sql() const override { return "INT"; }
+  type_t::bin_t bin() const override { return type_t::bin_t::int32; }
+  bool validate(sv val) const override { return validate_int32(val, std::numeric_limits<int32_t>::min()); }
 };
 
 struct type_date_t : base_t {
   const string sql() const override { return "DATE"; };
+  type_t::bin_t bin() const override { return type_t::bin_t::date; }
+  bool validate(sv val) const override { return val.empty() || parse_iso_date(val).has_value(); }
 };
 
 struct type_text_t : base_t {
   const string sql() const override { return "TEXT"; };
+  type_t::bin_t bin() const override { return type_t::bin_t::text; }
+  bool validate([[maybe_unused]] sv val) const override { return true; }
 };
 
 struct type_dec_t : base_t { // temporary stub
@@ -106,6 +135,11 @@ const string type_t::sqlSufix() const {
   return pimpl->sqlSufix();
 }
 
+type_t::bin_t type_t::bin() const {
+  assert(pimpl != nullptr && "Type is not finalized.");
+  return pimpl->bin();
+}
+
 // Допоміжна функція для парсингу визначень типів, як-от "varchar(100)"
 static std::pair<sv, sv> parse_type_def(sv type_str) {
   sv base_type = type_str;
@@ -0,0 +1,156 @@
+// Бенчмарк PgPool: затримка acquire() під сплесками навантаження і пропускна здатність
+// acquire/release за кількістю потоків у порівнянні з пулом на одному м'ютексі.
+// Потрібна доступна база: ./bench_pgpool "dbname=ky_bench" (або змінна KY_BENCH_DSN).
+#include "pgpool.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+uint32_t percentile(std::vector<uint32_t>& samples, size_t p) {
+    if (samples.empty()) return 0;
+    auto nth = samples.begin() + (samples.size() - 1) * p / 100;
+    std::nth_element(samples.begin(), nth, samples.end());
+    return *nth;
+}
+
+// Виконує короткий запит на з'єднанні - "робота" між acquire() і release()
+void run_query(PgConn* pgConn) {
+    PGresult* res = PQexec(pgConn->conn, "SELECT 1");
+    PQclear(res);
+}
+
+// Сплески: threads потоків одночасно хочуть з'єднання, далі пауза idle.
+// Пул стартує з одного з'єднання, тож перші сплески перевіряють ріст у фоні.
+void bench_bursts(const std::string& dsn, size_t hard_limit, int threads, int bursts,
+                  std::chrono::milliseconds idle) {
+    PgPool pool(dsn, hard_limit, std::chrono::seconds(1), std::chrono::seconds(60));
+
+    std::vector<uint32_t> samples;
+    std::mutex samples_mutex;
+    for (int b = 0; b < bursts; ++b) {
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&] {
+                const auto started = clock_type::now();
+                PgConn* pgConn = pool.acquire();
+                const auto waited = clock_type::now() - started;
+                run_query(pgConn);
+                pool.release(pgConn);
+                auto us = std::chrono::duration_cast<std::chrono::microseconds>(waited).count();
+                std::lock_guard<std::mutex> lock(samples_mutex);
+                samples.push_back(static_cast<uint32_t>(us));
+            });
+        }
+        for (auto& w : workers) w.join();
+        std::this_thread::sleep_for(idle);
+    }
+
+    const auto st = pool.stats();
+    std::cout << "bursts: " << bursts << " x " << threads << " threads, hard limit " << hard_limit << "\n"
+              << "  acquire p50 " << percentile(samples, 50) << " us"
+              << " | p99 " << percentile(samples, 99) << " us"
+              << " | max " << percentile(samples, 100) << " us\n"
+              << "  pool: total " << st.total << ", available " << st.available
+              << ", pool p99 " << st.wait_p99_us << " us" << std::endl;
+}
+
+// Пул до шардування: один м'ютекс, один список, одна умовна змінна.
+// З'єднання відкриті наперед, тож міряється лише ціна синхронізації.
+class LegacyPool {
+public:
+    LegacyPool(const std::string& dsn, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            storage.push_back(std::make_unique<PgConn>(dsn));
+            available.push_back(storage.back().get());
+        }
+    }
+    PgConn* acquire() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return !available.empty(); });
+        PgConn* pgConn = available.front();
+        available.pop_front();
+        return pgConn;
+    }
+    void release(PgConn* pgConn) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            available.push_back(pgConn);
+        }
+        cv.notify_one();
+    }
+
+private:
+    std::vector<std::unique_ptr<PgConn>> storage;
+    std::list<PgConn*> available;
+    std::mutex mutex;
+    std::condition_variable cv;
+};
+
+// acquire/release без запиту протягом duration; повертає операцій за секунду
+template <typename Pool>
+double acquire_release_rate(Pool& pool, int threads, std::chrono::milliseconds duration) {
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> ops{0};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&] {
+            uint64_t local = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                pool.release(pool.acquire());
+                ++local;
+            }
+            ops += local;
+        });
+    }
+    std::this_thread::sleep_for(duration);
+    stop = true;
+    for (auto& w : workers) w.join();
+    return ops.load() * 1000.0 / duration.count();
+}
+
+void bench_scaling(const std::string& dsn, size_t connections, std::chrono::milliseconds duration) {
+    PgPool sharded(dsn, connections, std::chrono::seconds(1), std::chrono::seconds(600));
+    // Прогрів: пул росте у фоні, доки всі connections не будуть відкриті
+    std::vector<PgConn*> held;
+    for (size_t i = 0; i < connections; ++i) held.push_back(sharded.acquire());
+    for (PgConn* pgConn : held) sharded.release(pgConn);
+    LegacyPool legacy(dsn, connections);
+
+    std::cout << "acquire/release, " << connections << " connections, ops/s:\n"
+              << std::setw(8) << "threads" << std::setw(14) << "single mutex" << std::setw(14) << "sharded"
+              << std::endl;
+    for (int threads : {1, 2, 4, 8, 16, 32}) {
+        const double legacy_rate = acquire_release_rate(legacy, threads, duration);
+        const double sharded_rate = acquire_release_rate(sharded, threads, duration);
+        std::cout << std::setw(8) << threads << std::setw(14) << static_cast<uint64_t>(legacy_rate)
+                  << std::setw(14) << static_cast<uint64_t>(sharded_rate) << std::endl;
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* env = std::getenv("KY_BENCH_DSN");
+    const std::string dsn = argc > 1 ? argv[1] : env ? env : "";
+    if (dsn.empty()) {
+        std::cerr << "Usage: bench_pgpool <conninfo>  (or KY_BENCH_DSN)" << std::endl;
+        return 2;
+    }
+    try {
+        bench_bursts(dsn, 10, 16, 20, std::chrono::milliseconds(50));
+        bench_scaling(dsn, 32, std::chrono::milliseconds(1000));
+    } catch (const std::exception& e) {
+        std::cerr << "bench_pgpool: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,628 @@
+// Регресії планів запитів SqlGenius: схеми ky-specs (library_management, project_management)
+// у локальній PostgreSQL, синтетичні дані заданого масштабу, типові комбінації фільтрів,
+// сортувань і сторінок Recordset та завантаження Record. Кожен SELECT, який згенерував SqlGenius,
+// повторюється під EXPLAIN (ANALYZE, BUFFERS); форма плану і час порівнюються з базовою лінією.
+// Потрібна окрема база - таблиці схем перестворюються:
+//   ./bench_plans "dbname=ky_bench" --scale 100000 --record      # записати базову лінію
+//   ./bench_plans "dbname=ky_bench" --scale 100000               # порівняти з нею
+#include "sqldrvpg.h"
+#include "rec.h"
+#include "transaction.h"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace ky;
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+using Direction = Recordset::Sort::Direction;
+
+// --- Специфікації ---
+
+// Слова рядка специфікації; дужки і [[...]] - частина слова: numeric(5, 2), check(a > 0).
+// Кома після слова - роздільник атрибутів: display_name(Users), description(...). # поза дужками - коментар.
+std::vector<string> split_words(sv line) {
+    std::vector<string> words;
+    string word;
+    int depth = 0;
+    for (char c : line) {
+        if (c == '(' || c == '[') ++depth;
+        if (c == ')' || c == ']') --depth;
+        if (depth == 0 && c == '#') break;
+        if (depth == 0 && (c == ' ' || c == '\t')) {
+            if (!word.empty()) words.push_back(std::move(word));
+            word.clear();
+            continue;
+        }
+        word += c;
+    }
+    if (!word.empty()) words.push_back(std::move(word));
+    for (auto& w : words) {
+        if (w.size() > 1 && w.back() == ',') w.pop_back();
+    }
+    return words;
+}
+
+// !flag1,flag2 - прапори, name(value) - атрибути
+void apply_words(const std::vector<string>& words, size_t from, flags_t& flags, attrs_t& attrs) {
+    for (size_t i = from; i < words.size(); ++i) {
+        sv w = words[i];
+        if (w[0] == '!') {
+            for (size_t start = 1; start < w.size();) {
+                size_t end = std::min(w.find(',', start), w.size());
+                if (end > start) flags.emplace(w.substr(start, end - start));
+                start = end + 1;
+            }
+        } else if (auto open = w.find('('); open != sv::npos && w.back() == ')') {
+            attrs[string(w.substr(0, open))] = string(w.substr(open + 1, w.size() - open - 2));
+        }
+    }
+}
+
+// Розділ tables файлу .ky (doc/ky-format.md): таблиці з прапорами й атрибутами,
+// поля "ім'я тип [!прапори] [атрибути]". У дереві немає завантажувача .ky, тож це мінімальний
+// читач лише для бенчмарку. Він НЕ підтримує:
+//  - значення атрибутів на кількох рядках (дужки з переносами);
+//  - ")" і "]" всередині сирих значень ([[...]]) - дужки лише рахуються;
+//  - розділ apps: макети, table_extension(...); індекси під зв'язки з макетів (link) тому не створюються;
+//  - перевірку відступів: таблиця - перший відступ після tables, глибше - поле.
+// Специфікація, що виходить за ці межі, дасть іншу схему, ніж у застосунку.
+void read_tables(Rack& rack, const string& path) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("cannot open " + path);
+
+    int section = -1, table_indent = -1;
+    Table* table = nullptr;
+    string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        const size_t pos = line.find_first_not_of(' ');
+        if (pos == string::npos || line[pos] == '#') continue;
+        const int indent = static_cast<int>(pos);
+        const auto words = split_words(sv(line).substr(pos));
+        if (words.empty()) continue;
+
+        if (section < 0) {
+            if (words[0] == "tables") section = indent;
+            continue;
+        }
+        if (indent <= section) break;  // наступний розділ
+        if (table_indent < 0) table_indent = indent;
+
+        if (indent == table_indent) {
+            if (rack.tables.get_map().count(words[0])) throw std::runtime_error(path + ": table " + words[0] + " is already defined");
+            table = rack.tables.get(words[0]);
+            apply_words(words, 1, table->flags, table->attrs);
+        } else {
+            if (!table || words.size() < 2) throw std::runtime_error(path + ": unexpected line: " + line);
+            Field* field = table->fields.get(words[0]);
+            field->type = rack.types.get(words[1]);
+            apply_words(words, 2, field->flags, field->attrs);
+        }
+    }
+}
+
+// --- Схема і дані ---
+
+// Скрипт generate_sql() по одному оператору: PQexecParams не виконує кілька за раз.
+// Крапка з комою всередині $$...$$ (DO-блоки FK) та '...' оператор не завершує.
+std::vector<string> split_statements(const string& script) {
+    std::vector<string> statements;
+    string current;
+    bool dollar = false, quote = false;
+    auto flush = [&] {
+        const size_t b = current.find_first_not_of(" \n\t");
+        if (b != string::npos) statements.push_back(current.substr(b));
+        current.clear();
+    };
+    for (size_t i = 0; i < script.size(); ++i) {
+        const char c = script[i];
+        if (!quote && c == '$' && i + 1 < script.size() && script[i + 1] == '$') {
+            dollar = !dollar;
+            current += "$$";
+            ++i;
+            continue;
+        }
+        if (!dollar && c == '\'') quote = !quote;
+        if (!dollar && !quote && c == ';') {
+            flush();
+            continue;
+        }
+        current += c;
+    }
+    flush();
+    return statements;
+}
+
+// Таблиці в порядку, в якому їх можна заповнити: спершу ті, на які посилаються
+std::vector<const Table*> load_order(const Rack& rack) {
+    std::vector<const Table*> pending, order;
+    for (const auto& [name, table] : rack.tables.get_map()) pending.push_back(table);
+    std::sort(pending.begin(), pending.end(), [](const Table* a, const Table* b) { return a->name < b->name; });
+
+    while (!pending.empty()) {
+        auto ready = std::find_if(pending.begin(), pending.end(), [&](const Table* table) {
+            for (const auto& [_, field] : table->fields.get_map()) {
+                const Table* target = field->type->is_ref() ? field->type->ref() : nullptr;
+                if (target && target != table && std::find(order.begin(), order.end(), target) == order.end()) return false;
+            }
+            return true;
+        });
+        if (ready == pending.end()) throw std::runtime_error("load_order: tables reference each other in a cycle");
+        order.push_back(*ready);
+        pending.erase(ready);
+    }
+    return order;
+}
+
+// Довідники (без ref-полів) - scale / 10 рядків, решта - scale
+size_t table_rows(const Table& table, size_t scale) {
+    for (const auto& [_, field] : table.fields.get_map()) {
+        if (field->type->is_ref()) return scale;
+    }
+    return std::max<size_t>(scale / 10, 1);
+}
+
+// Вираз значення поля для рядка g з generate_series. Таблиці щойно створені, тож id - 1..rows.
+// Текст неунікальних полів повторюється (g % 100), щоб фільтр за префіксом мав реальну селективність;
+// необов'язкові поля - NULL у 10% рядків, щоб keyset-сторінки проходили і по NULL-ключах.
+string value_sql(const Field& field, const std::map<string, size_t>& rows) {
+    const type_t& type = *field.type;
+    const string base = type.name.substr(0, type.name.find('('));
+    string expr;
+    if (type.is_ref()) {
+        expr = "1 + floor(random() * " + std::to_string(rows.at(type.ref()->name)) + ")::int";
+    } else if (base == "int") {
+        expr = "1 + floor(random() * 2000)::int";
+    } else if (base == "date") {
+        expr = "date '2000-01-01' + floor(random() * 9000)::int";
+    } else if (base == "timestamp") {
+        expr = "timestamp '2000-01-01' + random() * interval '9000 days'";
+    } else if (base == "varchar" || base == "text") {
+        // Приведення до varchar(n) обрізає значення до n символів
+        expr = "('" + field.name + " ' || " + (field.flags.count("unique") ? "g" : "g % 100") + ")::" + type.name;
+    } else {
+        expr = "(1 + random() * 8)::" + type.name;  // numeric(5, 2) та інші числові
+    }
+    if (!field.flags.count("required")) expr = "CASE WHEN random() < 0.1 THEN NULL ELSE " + expr + " END";
+    return expr;
+}
+
+// Перестворює таблиці схеми і заповнює їх; дані однакові між запусками (setseed)
+std::map<string, size_t> load_data(Rack& rack, SqlDB& db, size_t scale) {
+    const auto order = load_order(rack);
+    string drop = "DROP TABLE IF EXISTS ";
+    for (size_t i = 0; i < order.size(); ++i) drop += (i ? ", " : "") + order[i]->name;
+    db.execute(drop + " CASCADE", {});
+    for (const auto& statement : split_statements(rack.generate_sql())) db.execute(statement, {});
+
+    std::map<string, size_t> rows;
+    TransactionGuard tx(db);
+    db.query_once("SELECT setseed(0.42)", {});
+    for (const Table* table : order) {
+        rows[table->name] = table_rows(*table, scale);
+        string columns, values;
+        for (const auto& [name, field] : table->fields.get_map()) {
+            if (name == "id") continue;
+            columns += (columns.empty() ? "" : ", ") + field->sqlName();
+            values += (values.empty() ? "" : ", ") + value_sql(*field, rows);
+        }
+        const auto started = clock_type::now();
+        // unique(...) таблиці чи UNIQUE поля - випадкові повтори просто пропускаються
+        const int inserted = db.execute("INSERT INTO " + table->name + " (" + columns + ") SELECT " + values +
+                                            " FROM generate_series(1, " + std::to_string(rows[table->name]) +
+                                            ") AS g ON CONFLICT DO NOTHING",
+                                        {});
+        const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock_type::now() - started).count();
+        std::cout << "  " << std::left << std::setw(16) << table->name << std::right << std::setw(10) << inserted
+                  << " rows " << std::setw(8) << ms << " ms" << std::endl;
+    }
+    tx.commit();
+    db.execute("ANALYZE", {});
+    return rows;
+}
+
+// --- Запити ---
+
+// SqlDB, що передає запити драйверу і, поки увімкнено capture, запам'ятовує SELECT-и
+class PlanProbe : public SqlDB {
+public:
+    struct Captured {
+        string sql;
+        std::vector<string> params;
+    };
+
+    explicit PlanProbe(std::unique_ptr<SqlDB> db) : db(std::move(db)) {}
+    SqlDB& inner() { return *db; }
+
+    void capture(bool on) {
+        std::lock_guard<std::mutex> lock(mutex);
+        capturing = on;
+        if (on) captured.clear();
+    }
+    std::vector<Captured> take() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return std::move(captured);
+    }
+
+    std::unique_ptr<Result> query(sv sql, const std::vector<string>& params) override {
+        record(sql, params);
+        return db->query(sql, params);
+    }
+    std::unique_ptr<Result> query_once(sv sql, const std::vector<string>& params) override {
+        record(sql, params);
+        return db->query_once(sql, params);
+    }
+    std::vector<std::unique_ptr<Result>> query_pipeline(const std::vector<Statement>& batch) override {
+        for (const auto& st : batch) record(st.sql, st.params);
+        return db->query_pipeline(batch);
+    }
+    std::unique_ptr<Stream> query_stream(sv sql, const std::vector<string>& params, int chunk_rows) override {
+        record(sql, params);
+        return db->query_stream(sql, params, chunk_rows);
+    }
+    int execute(sv sql, const std::vector<string>& params) override { return db->execute(sql, params); }
+
+    std::future<std::unique_ptr<Result>> query_async(sv sql, std::vector<string> params) override {
+        record(sql, params);
+        return db->query_async(sql, std::move(params));
+    }
+    std::future<std::vector<std::unique_ptr<Result>>> query_pipeline_async(const std::vector<Statement>& batch) override {
+        for (const auto& st : batch) record(st.sql, st.params);
+        return db->query_pipeline_async(batch);
+    }
+    std::future<int> execute_async(sv sql, std::vector<string> params) override {
+        return db->execute_async(sql, std::move(params));
+    }
+
+    void beginTransaction() override { db->beginTransaction(); }
+    void commit() override { db->commit(); }
+    void rollback() override { db->rollback(); }
+    bool inTransaction() const override { return db->inTransaction(); }
+
+private:
+    void record(sv sql, const std::vector<string>& params) {
+        const sv head = sql.substr(std::min(sql.find_first_not_of(" \n\t"), sql.size()));
+        if (!head.starts_with("SELECT") && !head.starts_with("WITH")) return;
+        std::lock_guard<std::mutex> lock(mutex);
+        if (capturing) captured.push_back({string(sql), params});
+    }
+
+    std::unique_ptr<SqlDB> db;
+    std::mutex mutex;
+    bool capturing = false;
+    std::vector<Captured> captured;
+};
+
+struct Scenario {
+    enum class Step {
+        FIRST_PAGE,  ///< Load() першої сторінки
+        DEEP_PAGE,   ///< SetPage() з OFFSET посередині таблиці
+        NEXT_PAGE,   ///< NextPage() і Load() - keyset від межі попередньої сторінки
+        CHILD_LIST,  ///< список деталей першого запису parent за полем link
+        RECORD       ///< Record::Load() першого запису списку
+    };
+    const char* name;
+    const char* table;
+    std::vector<const char*> fields;
+    std::vector<std::pair<const char*, const char*>> filters{};
+    std::vector<std::pair<const char*, Direction>> sorts{};
+    Step step = Step::FIRST_PAGE;
+    const char* parent = nullptr;
+    const char* link = nullptr;
+};
+
+using Step = Scenario::Step;
+
+// Значення фільтрів відповідають даним value_sql(): текст "<поле> N", дати з 2000-01-01
+const std::vector<Scenario> scenarios = {
+    // library_management
+    {"book.first_page", "book", {"title", "author.full_name", "genre", "publication_year"}, {}, {{"title", Direction::ASC}}},
+    {"book.title_prefix", "book", {"title", "author.full_name", "genre"}, {{"title", "title 42"}}, {{"title", Direction::ASC}}},
+    {"book.author_name", "book", {"title", "author.full_name"}, {{"author.full_name", "full_name 12"}}, {{"title", Direction::ASC}}},
+    {"book.year_range", "book", {"title", "publication_year"}, {{"publication_year", "1900:1950"}},
+     {{"publication_year", Direction::DESC}}},
+    {"book.deep_page", "book", {"title", "author.full_name"}, {}, {{"title", Direction::ASC}}, Step::DEEP_PAGE},
+    {"book.keyset_next", "book", {"title", "genre"}, {}, {{"genre", Direction::ASC}}, Step::NEXT_PAGE},
+    {"member.status", "member", {"full_name", "email", "join_date"}, {{"membership_status", "membership_status 3"}},
+     {{"join_date", Direction::DESC}}},
+    {"book_loan.due_before", "book_loan", {"book.title", "member.full_name", "due_date", "return_date"},
+     {{"due_date", "<2001-01-01"}}, {{"due_date", Direction::ASC}}},
+    {"book_loan.of_book", "book_loan", {"loan_date", "member.full_name", "return_date"}, {},
+     {{"loan_date", Direction::DESC}}, Step::CHILD_LIST, "book", "book"},
+    {"book.record", "book", {"title", "author.full_name", "genre", "isbn", "total_copies"}, {}, {}, Step::RECORD},
+    // project_management
+    {"tasks.status", "tasks", {"title", "project.name", "author.full_name", "status", "due_date"}, {{"status", "status 5"}},
+     {{"due_date", Direction::ASC}}},
+    {"tasks.keyset_next", "tasks", {"title", "priority", "due_date"}, {},
+     {{"priority", Direction::ASC}, {"due_date", Direction::DESC}}, Step::NEXT_PAGE},
+    {"tasks.of_project", "tasks", {"title", "status", "due_date"}, {}, {{"due_date", Direction::ASC}}, Step::CHILD_LIST,
+     "projects", "project"},
+    {"time_logs.user_name", "time_logs", {"task.title", "user.full_name", "hours_spent", "log_date"},
+     {{"user.full_name", "full_name 7"}}, {{"log_date", Direction::DESC}}},
+    {"comments.of_task", "comments", {"user.full_name", "content", "created_at"}, {}, {{"created_at", Direction::DESC}},
+     Step::CHILD_LIST, "tasks", "task"},
+    {"tasks.record", "tasks", {"title", "description", "status", "priority", "project.name", "author.full_name"}, {}, {},
+     Step::RECORD},
+};
+
+void show(Record& rec, const std::vector<const char*>& names) {
+    vector_prf fields;
+    for (sv name : names) fields.push_back(&rec.getRField(name));
+    rec.SetVisibleFields(fields);
+}
+
+// Перший запис table - джерело id для CHILD_LIST і RECORD
+std::unique_ptr<Recordset> first_row(Rack& rack, const char* table) {
+    auto rs = std::make_unique<Recordset>(*rack.qmodels.get(table));
+    show(*rs, {"id"});
+    rs->Load();
+    if (!rs->next()) throw std::runtime_error(string("no rows in ") + table);
+    return rs;
+}
+
+// Медіана часу кроку сценарію за repeat повторів, мс; SELECT-и останнього повтору - у probe
+double run_scenario(Rack& rack, PlanProbe& probe, const Scenario& sc, const std::map<string, size_t>& rows, int repeat) {
+    const QModel& qmodel = *rack.qmodels.get(sc.table);
+    std::unique_ptr<Recordset> source, list;
+    std::unique_ptr<Record> record;
+
+    if (sc.step == Step::RECORD) {
+        source = first_row(rack, sc.table);
+        record = std::make_unique<Record>(static_cast<const Record&>(*source).rkey);
+        show(*record, sc.fields);
+    } else {
+        if (sc.step == Step::CHILD_LIST) {
+            source = first_row(rack, sc.parent);
+            list = std::make_unique<Recordset>(qmodel, static_cast<const Record&>(*source).rkey, sc.link);
+        } else {
+            list = std::make_unique<Recordset>(qmodel);
+        }
+        show(*list, sc.fields);
+        for (const auto& [field, value] : sc.filters) list->SetFilter(list->getRField(field), value);
+        for (const auto& [field, dir] : sc.sorts) list->AddSort(list->getRField(field), dir);
+        if (sc.step == Step::DEEP_PAGE) {
+            const auto it = rows.find(sc.table);
+            list->SetPage({static_cast<uint32_t>(it == rows.end() ? 0 : it->second / 2), 30});
+        }
+        if (sc.step == Step::NEXT_PAGE) list->Load();
+    }
+
+    std::vector<double> samples;
+    for (int i = 0; i < repeat; ++i) {
+        probe.capture(i + 1 == repeat);
+        const auto started = clock_type::now();
+        if (record) {
+            record->Load();
+        } else {
+            if (sc.step == Step::NEXT_PAGE) list->NextPage();
+            list->Load();
+        }
+        samples.push_back(std::chrono::duration<double, std::milli>(clock_type::now() - started).count());
+    }
+    probe.capture(false);
+    std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+    return samples[samples.size() / 2];
+}
+
+// --- Плани ---
+
+struct Plan {
+    string json;
+    string shape;  ///< вузли плану в порядку обходу: "Limit>Index Scan using book_title_idx on book"
+    double planning_ms = 0, execution_ms = 0;
+    long shared_hit = 0, shared_read = 0;  ///< кореневий вузол - сума по всьому плану
+};
+
+// Перше числове значення ключа у JSON-плані
+double json_number(sv json, sv key) {
+    const string needle = "\"" + string(key) + "\": ";
+    const size_t pos = json.find(needle);
+    if (pos == sv::npos) return 0;
+    return std::strtod(string(json.substr(pos + needle.size(), 32)).c_str(), nullptr);
+}
+
+// У FORMAT JSON "Node Type" - перший ключ вузла, "Relation Name" та "Index Name" - до його "Plans",
+// тож порядок ключів у тексті - обхід дерева в глибину
+string plan_shape(sv json) {
+    static const sv keys[] = {"\"Node Type\": \"", "\"Index Name\": \"", "\"Relation Name\": \""};
+    static const sv glue[] = {">", " using ", " on "};
+    string shape;
+    for (size_t pos = 0;;) {
+        size_t next = sv::npos, which = 0;
+        for (size_t k = 0; k < 3; ++k) {
+            if (size_t at = json.find(keys[k], pos); at < next) next = at, which = k;
+        }
+        if (next == sv::npos) break;
+        const size_t begin = next + keys[which].size();
+        const size_t end = json.find('"', begin);
+        if (which != 0 || !shape.empty()) shape += glue[which];
+        shape += json.substr(begin, end - begin);
+        pos = end;
+    }
+    return shape;
+}
+
+Plan explain(SqlDB& db, const PlanProbe::Captured& st) {
+    auto res = db.query_once("EXPLAIN (ANALYZE, BUFFERS, FORMAT JSON) " + st.sql, st.params);
+    Plan plan;
+    plan.json = string(res->get_value(0, 0).value_or(""));
+    plan.shape = plan_shape(plan.json);
+    plan.planning_ms = json_number(plan.json, "Planning Time");
+    plan.execution_ms = json_number(plan.json, "Execution Time");
+    plan.shared_hit = static_cast<long>(json_number(plan.json, "Shared Hit Blocks"));
+    plan.shared_read = static_cast<long>(json_number(plan.json, "Shared Read Blocks"));
+    return plan;
+}
+
+// --- Базова лінія ---
+
+// Рядок базової лінії: "ключ<TAB>мс<TAB>форма". Ключ сценарію - час кроку (форма "-"),
+// "сценарій#N" - N-й SELECT кроку з часом виконання за EXPLAIN ANALYZE.
+struct Measure {
+    double ms = 0;
+    string shape = "-";
+};
+using Measures = std::map<string, Measure>;
+
+Measures read_baseline(const string& path) {
+    Measures baseline;
+    std::ifstream in(path);
+    string line;
+    while (std::getline(in, line)) {
+        const size_t t1 = line.find('\t'), t2 = line.find('\t', t1 + 1);
+        if (t1 == string::npos || t2 == string::npos) continue;
+        baseline[line.substr(0, t1)] = {std::strtod(line.c_str() + t1 + 1, nullptr), line.substr(t2 + 1)};
+    }
+    return baseline;
+}
+
+void write_baseline(const string& path, const Measures& results) {
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error("cannot write " + path);
+    for (const auto& [key, m] : results) out << key << '\t' << std::fixed << std::setprecision(3) << m.ms << '\t' << m.shape << '\n';
+}
+
+// Регресія: інша форма плану (Index Scan став Seq Scan) або час більший за базовий
+// у (1 + tolerance) разів і щонайменше на floor_ms - шум коротких запитів не рахується
+int compare(const Measures& results, const Measures& baseline, double tolerance, double floor_ms) {
+    int regressions = 0;
+    for (const auto& [key, m] : results) {
+        auto it = baseline.find(key);
+        if (it == baseline.end()) {
+            std::cout << "NEW         " << key << std::endl;
+            continue;
+        }
+        const Measure& base = it->second;
+        if (m.shape != base.shape) {
+            std::cout << "REGRESSION  " << key << ": plan changed\n    was: " << base.shape << "\n    now: " << m.shape
+                      << std::endl;
+            ++regressions;
+        } else if (m.ms > base.ms * (1 + tolerance) && m.ms - base.ms > floor_ms) {
+            std::cout << "REGRESSION  " << key << ": " << std::fixed << std::setprecision(2) << base.ms << " -> " << m.ms
+                      << " ms" << std::endl;
+            ++regressions;
+        }
+    }
+    for (const auto& [key, base] : baseline) {
+        if (!results.count(key)) std::cout << "MISSING     " << key << std::endl;
+    }
+    return regressions;
+}
+
+struct Options {
+    string dsn;
+    string specs = "../ky-specs";
+    size_t scale = 100000;
+    int repeat = 5;
+    string baseline = "plans.baseline.tsv";
+    bool record = false;
+    bool load = true;
+    string plans_dir;  ///< порожній - JSON планів не зберігаються
+    double tolerance = 0.5;
+    double floor_ms = 1.0;
+};
+
+int usage() {
+    std::cerr << "Usage: bench_plans <conninfo> [--scale N] [--repeat N] [--specs DIR] [--baseline FILE] [--record]\n"
+                 "                   [--no-load] [--plans DIR] [--tolerance 0.5] [--floor-ms 1]\n"
+                 "  conninfo can also come from KY_BENCH_DSN; the database must be dedicated to the bench."
+              << std::endl;
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (const char* env = std::getenv("KY_BENCH_DSN")) opt.dsn = env;
+    for (int i = 1; i < argc; ++i) {
+        const sv arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--scale" && has_value) opt.scale = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--repeat" && has_value) opt.repeat = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--specs" && has_value) opt.specs = argv[++i];
+        else if (arg == "--baseline" && has_value) opt.baseline = argv[++i];
+        else if (arg == "--plans" && has_value) opt.plans_dir = argv[++i];
+        else if (arg == "--tolerance" && has_value) opt.tolerance = std::strtod(argv[++i], nullptr);
+        else if (arg == "--floor-ms" && has_value) opt.floor_ms = std::strtod(argv[++i], nullptr);
+        else if (arg == "--record") opt.record = true;
+        else if (arg == "--no-load") opt.load = false;
+        else if (!arg.starts_with("--")) opt.dsn = arg;
+        else return usage();
+    }
+    if (opt.dsn.empty() || opt.scale == 0) return usage();
+
+    try {
+        // Rack - глобальний; заповнюємо його тут, як це робить парсер (doc/const_cast_design_discussion.md)
+        Rack& rack = const_cast<Rack&>(Rack::get());
+        for (const char* spec : {"library_management.ky", "project_management.ky"}) read_tables(rack, opt.specs + "/" + spec);
+        rack.finalize();
+
+        auto probe_owner = std::make_unique<PlanProbe>(std::make_unique<SqlDrvPg>(opt.dsn));
+        PlanProbe& probe = *probe_owner;
+        rack.sqldb = std::move(probe_owner);
+
+        std::map<string, size_t> rows;
+        if (opt.load) {
+            std::cout << "loading scale " << opt.scale << ":" << std::endl;
+            rows = load_data(rack, probe.inner(), opt.scale);
+        } else {
+            for (const auto& [name, table] : rack.tables.get_map()) rows[string(name)] = table_rows(*table, opt.scale);
+        }
+        if (!opt.plans_dir.empty()) std::filesystem::create_directories(opt.plans_dir);
+
+        Measures results;
+        std::cout << std::left << std::setw(24) << "scenario" << std::right << std::setw(10) << "step ms" << std::setw(10)
+                  << "exec ms" << std::setw(10) << "plan ms" << std::setw(10) << "hit" << std::setw(8) << "read"
+                  << "  plan" << std::endl;
+        for (const auto& sc : scenarios) {
+            const double step_ms = run_scenario(rack, probe, sc, rows, opt.repeat);
+            results[sc.name] = {step_ms, "-"};
+            std::cout << std::left << std::setw(24) << sc.name << std::right << std::fixed << std::setprecision(2)
+                      << std::setw(10) << step_ms << std::endl;
+
+            const auto statements = probe.take();
+            for (size_t n = 0; n < statements.size(); ++n) {
+                const Plan plan = explain(probe.inner(), statements[n]);
+                const string key = string(sc.name) + "#" + std::to_string(n + 1);
+                results[key] = {plan.execution_ms, plan.shape};
+                std::cout << std::left << std::setw(24) << ("  #" + std::to_string(n + 1)) << std::right
+                          << std::setw(10) << "" << std::setw(10) << plan.execution_ms << std::setw(10)
+                          << plan.planning_ms << std::setw(10) << plan.shared_hit << std::setw(8) << plan.shared_read
+                          << "  " << plan.shape << std::endl;
+                if (!opt.plans_dir.empty()) {
+                    const string file = opt.plans_dir + "/" + string(sc.name) + "." + std::to_string(n + 1);
+                    std::ofstream(file + ".sql") << statements[n].sql << "\n";
+                    std::ofstream(file + ".json") << plan.json << "\n";
+                }
+            }
+        }
+
+        if (opt.record) {
+            write_baseline(opt.baseline, results);
+            std::cout << "baseline written to " << opt.baseline << std::endl;
+            return 0;
+        }
+        if (!std::filesystem::exists(opt.baseline)) {
+            std::cout << "no baseline " << opt.baseline << " - run with --record first" << std::endl;
+            return 0;
+        }
+        const int regressions = compare(results, read_baseline(opt.baseline), opt.tolerance, opt.floor_ms);
+        std::cout << regressions << " regression(s) against " << opt.baseline << std::endl;
+        return regressions ? 1 : 0;
+    } catch (const std::exception& e) {
+        std::cerr << "bench_plans: " << e.what() << std::endl;
+        return 1;
+    }
+}
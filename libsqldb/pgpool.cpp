@@ -2,12 +2,17 @@
 #include <iostream>
 #include <algorithm>
 #include <iomanip>
+#include <limits>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
 
 // --- Реалізація PgConn ---
 
 int PgConn::arc_hard_limit = 15;
+ArcEvictionPolicy PgConn::arc_policy = ArcEvictionPolicy::CostAware;
 
-PgConn::PgConn(const std::string& connInfo) : cache(arc_hard_limit) {
+PgConn::PgConn(const std::string& connInfo) : cache(arc_hard_limit, arc_policy) {
     conn = PQconnectdb(connInfo.c_str());
     if (PQstatus(conn) != CONNECTION_OK) {
         throw std::runtime_error("Connection failed: " + std::string(PQerrorMessage(conn)));
@@ -15,11 +20,40 @@ PgConn::PgConn(const std::string& connInfo) : cache(arc_hard_limit) {
 }
 
 PgConn::~PgConn() {
+    // PgPrepStmt закривають запити через conn - до PQfinish, а не після
+    cache.clear();
     if (conn) {
         PQfinish(conn);
     }
 }
 
+bool PgConn::leave_pipeline(bool synced) {
+    if (PQpipelineStatus(conn) == PQ_PIPELINE_OFF) return PQstatus(conn) == CONNECTION_OK;
+    if (PQstatus(conn) != CONNECTION_OK || PQsetnonblocking(conn, 0) != 0) return false;
+    // Без Sync сервер не відповість на вже відправлені запити
+    if (!synced && !PQpipelineSync(conn)) return false;
+
+    // PQexitPipelineMode не вдається, поки є невичитані результати.
+    // Два NULL поспіль - черга порожня, а вийти все одно не вийшло.
+    int idle = 0;
+    while (!PQexitPipelineMode(conn)) {
+        if (PQstatus(conn) != CONNECTION_OK) return false;
+        PGresult* res = PQgetResult(conn);
+        if (!res) {
+            if (++idle > 1) return false;
+            continue;
+        }
+        idle = 0;
+        PQclear(res);
+    }
+    return true;
+}
+
+bool PgConn::reusable() const {
+    return PQstatus(conn) == CONNECTION_OK && PQpipelineStatus(conn) == PQ_PIPELINE_OFF &&
+           !PQisnonblocking(conn) && PQtransactionStatus(conn) == PQTRANS_IDLE;
+}
+
 
 // --- Реалізація PgPool ---
 
@@ -28,84 +62,287 @@ PgPool::PgPool(std::string connInfo, size_t hardLimit,
     : connInfo(std::move(connInfo)),
       hardLimit(hardLimit),
       growthTimeout(growthTimeout),
-      idleTimeout(idleTimeout)
+      idleTimeout(idleTimeout),
+      // Шардів більше за з'єднання не буває потрібно
+      shard_count(std::clamp<size_t>(std::thread::hardware_concurrency(), 1, std::max<size_t>(1, hardLimit))),
+      shards(std::make_unique<Shard[]>(shard_count))
 {
+    for (size_t i = 0; i < shard_count; ++i) {
+        shards[i].wait_samples.reserve(wait_samples_size);
+    }
+
     // Створюємо 1 бандл на старті
     auto initial_bundle = std::make_unique<PgConn>(this->connInfo);
-    available.push_back(initial_bundle.get());
+    push_idle(shards[0], initial_bundle.get());
     storage.push_back(std::move(initial_bundle));
+
+    maintainer = std::thread(&PgPool::maintenance_loop, this);
 }
 
-PgPool::~PgPool() = default;
+PgPool::~PgPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    grow_cv.notify_all();
+    maintainer.join();
+}
 
-void PgPool::release(PgConn* pgConn) {
-    std::lock_guard<std::mutex> lock(mutex);
-    pgConn->last_released_time = std::chrono::steady_clock::now();
-    available.push_back(pgConn);
-    cv.notify_one();
+size_t PgPool::home_shard() const {
+    // Шард закріплюється за потоком: з'єднання, яке потік повернув, він же і отримає,
+    // разом з уже підготовленими на ньому запитами.
+    thread_local const size_t thread_hash = std::hash<std::thread::id>{}(std::this_thread::get_id());
+    return thread_hash % shard_count;
 }
 
-PgConn* PgPool::acquire() {
+bool PgPool::need_growth_unlocked() const {
+    if (storage.size() + pending >= hardLimit) return false;
+    // Кожен потік, що чекає, отримує своє з'єднання, і ще одне тримаємо про запас,
+    // щоб наступний сплеск не чекав зовсім.
+    size_t demand = waiters.load() + (idle_count.load() == 0 ? 1 : 0);
+    return demand > pending;
+}
+
+void PgPool::signal_growth() {
+    // Порожня критична секція: фоновий потік або ще не перевірив умову, або вже чекає.
+    { std::lock_guard<std::mutex> lock(mutex); }
+    grow_cv.notify_one();
+}
+
+void PgPool::maintenance_loop() {
+    // Прибирання простою - у фоні, а не в кожному acquire().
+    const auto reap_interval = std::max<std::chrono::seconds>(std::chrono::seconds(1), idleTimeout / 2);
+    auto next_reap = std::chrono::steady_clock::now() + reap_interval;
+
     std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        grow_cv.wait_until(lock, next_reap, [this] { return stopping || need_growth_unlocked(); });
+        if (stopping) return;
 
-    // --- Логіка скорочення ---
-    if (!available.empty()) {
-        auto now = std::chrono::steady_clock::now();
-        
-        // Ітеруємо storage у зворотному порядку (від найновіших до найстаріших)
-        for (int i = storage.size() - 1; i >= 0; --i) {
-            if (storage.size() <= minLimit) {
-                break; 
-            }
-            PgConn* bundle_to_check = storage[i].get();
-            auto available_it = std::find(available.begin(), available.end(), bundle_to_check);
-
-            if (available_it != available.end()) {
-                // Бандл вільний. Перевіряємо його таймаут.
-                if (now - bundle_to_check->last_released_time > idleTimeout) {
-                    // Цей бандл прострочений. Видаляємо його.
-                    std::cout << "[PgPool] Pruning newest idle connection." << std::endl;
-                    available.erase(available_it);
-                    storage.erase(storage.begin() + i);
-                } else {
-                    // Знайшли найновіший вільний бандл, який ще не прострочений.
-                    // Припиняємо будь-яке подальше скорочення.
-                    break; 
-                }
-            }
+        if (std::chrono::steady_clock::now() >= next_reap) {
+            std::vector<std::unique_ptr<PgConn>> reaped;
+            reap_idle_unlocked(reaped);
+            next_reap = std::chrono::steady_clock::now() + reap_interval;
+            // PQfinish - без блокування
+            lock.unlock();
+            reaped.clear();
+            lock.lock();
+            continue;
+        }
+
+        ++pending;
+        lock.unlock();
+        std::unique_ptr<PgConn> new_bundle;
+        try {
+            new_bundle = std::make_unique<PgConn>(connInfo);
+        } catch (const std::exception& e) {
+            std::cout << "[PgPool] Background connect failed: " << e.what() << std::endl;
+        }
+        lock.lock();
+        --pending;
+
+        if (!new_bundle) {
+            // Не перевантажуємо сервер спробами: пауза або до зупинки пулу.
+            grow_cv.wait_for(lock, growthTimeout, [this] { return stopping; });
+            continue;
         }
+        std::cout << "[PgPool] Opened new connection in background." << std::endl;
+        push_idle(shards[next_grow_shard++ % shard_count], new_bundle.get());
+        storage.push_back(std::move(new_bundle));
+        print_stats_unlocked();
+        cv.notify_one();
     }
+}
 
-    // --- Логіка отримання/зростання ---
-    while(true) { 
-        if (!available.empty()) {
-            PgConn* pgConn = available.front();
-            available.pop_front();
-            return pgConn;
+void PgPool::reap_idle_unlocked(std::vector<std::unique_ptr<PgConn>>& reaped) {
+    auto now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < shard_count && storage.size() > minLimit; ++i) {
+        Shard& shard = shards[i];
+        std::lock_guard<std::mutex> shard_lock(shard.mutex);
+        for (auto it = shard.available.begin(); it != shard.available.end() && storage.size() > minLimit;) {
+            PgConn* pgConn = *it;
+            if (now - pgConn->last_released_time <= idleTimeout) {
+                ++it;
+                continue;
+            }
+            std::cout << "[PgPool] Pruning idle connection." << std::endl;
+            it = shard.available.erase(it);
+            --idle_count;
+            auto st = std::find_if(storage.begin(), storage.end(),
+                                   [pgConn](const auto& p) { return p.get() == pgConn; });
+            reaped.push_back(std::move(*st));
+            storage.erase(st);
         }
+    }
+}
 
-        if (cv.wait_for(lock, growthTimeout) == std::cv_status::timeout) {
-            if (storage.size() < hardLimit) {
-                std::cout << "[PgPool] No available connections. Creating new." << std::endl;
-                auto new_bundle = std::make_unique<PgConn>(connInfo);
-                PgConn* raw_ptr = new_bundle.get();
-                storage.push_back(std::move(new_bundle));
-                print_stats_unlocked();
-                return raw_ptr;
-            } else {
-                 std::cout << "[PgPool] Timeout, but hard limit reached. Waiting again." << std::endl;
+void PgPool::push_idle(Shard& shard, PgConn* pgConn) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.available.push_back(pgConn);
+    ++idle_count;
+}
+
+void PgPool::release(PgConn* pgConn) {
+    if (!pgConn->reusable()) {
+        // Наступний користувач отримав би чужі результати або "not allowed in pipeline mode"
+        discard(pgConn);
+        return;
+    }
+    pgConn->last_released_time = std::chrono::steady_clock::now();
+    push_idle(shards[home_shard()], pgConn);
+    // Спільний м'ютекс - лише якщо хтось чекає: потік у acquire() чи PgLoop з чергою
+    const bool wake_hook = release_wanted.load();
+    if (waiters.load() > 0 || wake_hook) {
+        std::lock_guard<std::mutex> lock(mutex);
+        cv.notify_one();
+        if (wake_hook && release_hook) release_hook();
+    }
+}
+
+void PgPool::set_release_hook(std::function<void()> hook) {
+    std::lock_guard<std::mutex> lock(mutex);
+    release_hook = std::move(hook);
+}
+
+void PgPool::discard(PgConn* pgConn) {
+    std::unique_ptr<PgConn> dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto st = std::find_if(storage.begin(), storage.end(),
+                               [pgConn](const auto& p) { return p.get() == pgConn; });
+        if (st == storage.end()) return;
+        dropped = std::move(*st);
+        storage.erase(st);
+    }
+    std::cout << "[PgPool] Discarding connection in unusable state." << std::endl;
+    // PQfinish - без блокування; заміну відкриє maintenance_loop(), якщо хтось чекає
+    dropped.reset();
+    signal_growth();
+}
+
+PgConn* PgPool::take(std::string_view sql) {
+    const size_t home = home_shard();
+
+    // --- Логіка спорідненості з підготовленими запитами ---
+    // Спершу свій шард (сюди цей потік повертав свої з'єднання), далі інші: з'єднання
+    // з готовим запитом економить Parse, що дорожче за блокування ще кількох шардів.
+    if (!sql.empty()) {
+        const ArcKey key(sql);  // хешуємо раз на всі з'єднання
+        for (size_t i = 0; i < shard_count; ++i) {
+            Shard& shard = shards[(home + i) % shard_count];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = std::find_if(shard.available.begin(), shard.available.end(),
+                                   [&](PgConn* c) { return c->cache.contains(key); });
+            if (it != shard.available.end()) {
+                ++affinity_hits;
+                PgConn* pgConn = *it;
+                shard.available.erase(it);
+                --idle_count;
+                return pgConn;
             }
         }
     }
+
+    // Свій шард, далі крадемо з інших
+    for (size_t i = 0; i < shard_count; ++i) {
+        Shard& shard = shards[(home + i) % shard_count];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (shard.available.empty()) continue;
+        PgConn* pgConn = shard.available.front();
+        shard.available.pop_front();
+        --idle_count;
+        if (!sql.empty()) ++affinity_misses;
+        return pgConn;
+    }
+    return nullptr;
+}
+
+void PgPool::record_wait(Shard& shard, std::chrono::steady_clock::duration waited) {
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(waited).count();
+    uint32_t sample = static_cast<uint32_t>(std::min<long long>(us, std::numeric_limits<uint32_t>::max()));
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.wait_samples.size() < wait_samples_size) {
+        shard.wait_samples.push_back(sample);
+    } else {
+        shard.wait_samples[shard.wait_samples_next] = sample;
+    }
+    shard.wait_samples_next = (shard.wait_samples_next + 1) % wait_samples_size;
+}
+
+PgConn* PgPool::acquire() {
+    return acquire(std::string_view{});
+}
+
+PgConn* PgPool::acquire(std::string_view sql) {
+    const auto started = std::chrono::steady_clock::now();
+
+    PgConn* pgConn = take(sql);
+    if (pgConn) {
+        if (idle_count.load() == 0) signal_growth();  // Забрали останнє - готуємо запасне
+    } else {
+        // Повільний шлях: нові з'єднання відкриває maintenance_loop(), тут лише чекаємо.
+        // waiters збільшується ДО повторного пошуку, тому release() або побачить очікувача,
+        // або його з'єднання знайде take().
+        std::unique_lock<std::mutex> lock(mutex);
+        ++waiters;
+        grow_cv.notify_one();
+        cv.wait(lock, [&] { return (pgConn = take(sql)) != nullptr; });
+        --waiters;
+    }
+
+    ++acquires;
+    record_wait(shards[home_shard()], std::chrono::steady_clock::now() - started);
+    return pgConn;
+}
+
+PgConn* PgPool::try_acquire(std::string_view sql) {
+    PgConn* pgConn = take(sql);
+    if (!pgConn || idle_count.load() == 0) {
+        signal_growth();  // Попит є - хай фон відкриє з'єднання
+    }
+    return pgConn;
 }
 
 // Нова приватна функція, що не блокує м'ютекс
 void PgPool::print_stats_unlocked() const {
     std::cout << "[Stats] Total: " << storage.size()
-              << " | Available: " << available.size()
+              << " | Available: " << idle_count.load()
+              << " | Waiting: " << waiters.load()
+              << " | Opening: " << pending
+              << " | Affinity hits/misses: " << affinity_hits.load() << "/" << affinity_misses.load()
               << std::endl;
 }
 
+PgPool::Stats PgPool::stats() const {
+    Stats st;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        st.total = storage.size();
+        st.pending = pending;
+    }
+    st.affinity_hits = affinity_hits.load();
+    st.affinity_misses = affinity_misses.load();
+    st.acquires = acquires.load();
+    st.available = idle_count.load();
+    st.waiters = waiters.load();
+
+    std::vector<uint32_t> sorted;
+    for (size_t i = 0; i < shard_count; ++i) {
+        std::lock_guard<std::mutex> lock(shards[i].mutex);
+        sorted.insert(sorted.end(), shards[i].wait_samples.begin(), shards[i].wait_samples.end());
+    }
+    if (!sorted.empty()) {
+        auto pct = [&](size_t p) {
+            auto nth = sorted.begin() + (sorted.size() - 1) * p / 100;
+            std::nth_element(sorted.begin(), nth, sorted.end());
+            return *nth;
+        };
+        st.wait_p50_us = pct(50);
+        st.wait_p99_us = pct(99);
+    }
+    return st;
+}
+
 // Публічна функція, як і раніше, блокує м'ютекс
 void PgPool::print_stats() const {
     std::lock_guard<std::mutex> lock(mutex);
@@ -115,8 +352,292 @@ void PgPool::print_stats() const {
 // --- Реалізація PgPoolRaii ---
 PgPoolRaii::PgPoolRaii(PgPool& pool) : pool(pool), pgConn(pool.acquire()) {}
 
+PgPoolRaii::PgPoolRaii(PgPool& pool, std::string_view sql) : pool(pool), pgConn(pool.acquire(sql)) {}
+
+PgPoolRaii::PgPoolRaii(PgPool& pool, PgConn* pinned, std::string_view sql)
+    : pool(pool), pgConn(pinned ? pinned : pool.acquire(sql)), owned(pinned == nullptr) {}
+
 PgPoolRaii::~PgPoolRaii() {
-    if (pgConn) {
+    if (pgConn && owned) {
         pool.release(pgConn);
     }
 }
+
+// --- Реалізація PgLoop ---
+
+PgLoop::PgLoop(PgPool& pool) : pool(pool) {
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epfd < 0 || wakefd < 0) {
+        if (epfd >= 0) close(epfd);
+        if (wakefd >= 0) close(wakefd);
+        throw std::runtime_error("PgLoop: epoll/eventfd initialization failed.");
+    }
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.ptr = nullptr;  // nullptr - це wakefd
+    epoll_ctl(epfd, EPOLL_CTL_ADD, wakefd, &ev);
+    pool.set_release_hook([this] { wake(); });
+
+    worker = std::thread(&PgLoop::run, this);
+}
+
+PgLoop::~PgLoop() {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        stopping = true;
+    }
+    wake();
+    worker.join();
+    pool.want_release(false);
+    pool.set_release_hook(nullptr);
+    close(wakefd);
+    close(epfd);
+}
+
+void PgLoop::submit(std::vector<Stmt> stmts, done_t done) {
+    auto op = std::make_unique<Op>();
+    op->stmts = std::move(stmts);
+    op->done = std::move(done);
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        if (stopping) {
+            throw std::runtime_error("PgLoop is stopping.");
+        }
+        queued.push_back(std::move(op));
+    }
+    wake();
+}
+
+void PgLoop::wake() {
+    uint64_t one = 1;
+    [[maybe_unused]] auto n = write(wakefd, &one, sizeof(one));
+}
+
+void PgLoop::run() {
+    epoll_event events[64];
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            if (stopping) {
+                // Нові операції вже не приймаються; ті, що в черзі, відхиляємо,
+                // а ті, що в польоті, дочитуємо, щоб повернути з'єднання чистими.
+                auto rejected = std::move(queued);
+                queued.clear();
+                lock.unlock();
+                for (auto& op : rejected) op->done({}, "PgLoop is stopping.");
+                if (active.empty()) return;
+            }
+        }
+        start_queued();
+
+        // Операції без з'єднання чекають разом з усіма: release() будить цикл через wakefd.
+        int n = epoll_wait(epfd, events, 64, -1);
+        for (int i = 0; i < n; ++i) {
+            auto* op = static_cast<Op*>(events[i].data.ptr);
+            if (!op) {
+                uint64_t v;
+                [[maybe_unused]] auto r = read(wakefd, &v, sizeof(v));
+                continue;
+            }
+            on_ready(op, events[i].events);
+        }
+    }
+}
+
+void PgLoop::start_queued() {
+    while (true) {
+        std::unique_ptr<Op> op;
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            if (queued.empty()) {
+                pool.want_release(false);
+                return;
+            }
+            op = std::move(queued.front());
+            queued.pop_front();
+        }
+
+        auto hot = std::find_if(op->stmts.begin(), op->stmts.end(), [](const Stmt& st) { return !st.once; });
+        const std::string_view hot_sql = hot != op->stmts.end() ? std::string_view(hot->sql) : std::string_view{};
+        op->pgConn = pool.try_acquire(hot_sql);
+        if (!op->pgConn) {
+            // Спершу просимо release() розбудити цикл, тоді пробуємо ще раз: з'єднання, звільнене
+            // між спробами, або знайдеться зараз, або його release() вже побачить прохання.
+            pool.want_release(true);
+            op->pgConn = pool.try_acquire(hot_sql);
+        }
+        if (!op->pgConn) {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            queued.push_front(std::move(op));
+            return;
+        }
+
+        Op* raw = op.get();
+        active.emplace(raw, std::move(op));
+        if (!send(*raw)) {
+            finish(raw);
+        }
+    }
+}
+
+bool PgLoop::send(Op& op) {
+    PGconn* conn = op.pgConn->conn;
+    if (PQsetnonblocking(conn, 1) != 0 || !PQenterPipelineMode(conn)) {
+        op.error = PQerrorMessage(conn);
+        return false;
+    }
+
+    op.sent_at = std::chrono::steady_clock::now();
+    std::unordered_map<std::string_view, size_t> batch_prepares;  // sql -> індекс у op.prepares
+    for (const auto& st : op.stmts) {
+        std::vector<const char*> param_values;
+        param_values.reserve(st.params.size());
+        for (const auto& p : st.params) {
+            param_values.push_back(p.c_str());
+        }
+        // Промах кешу готуємо в тому ж пакеті: PQsendPrepare не блокує, Parse іде перед Bind/Execute
+        const char* name = nullptr;
+        if (!st.once) {
+            if (PgPrepStmt* stmt = op.pgConn->cache.get(st.sql)) {
+                name = stmt->stmtName.c_str();
+            } else {
+                auto [it, added] = batch_prepares.try_emplace(st.sql, op.prepares.size());
+                if (added) {
+                    op.prepares.push_back({st.sql, PgPrepStmt::next_name()});
+                    if (!PQsendPrepare(conn, op.prepares.back().name.c_str(), st.sql.c_str(), 0, nullptr)) {
+                        op.error = PQerrorMessage(conn);
+                        break;
+                    }
+                    op.commands.push_back(static_cast<int>(it->second));
+                }
+                name = op.prepares[it->second].name.c_str();
+            }
+        }
+        int sent = name
+            ? PQsendQueryPrepared(conn, name, st.params.size(), param_values.data(), nullptr, nullptr, st.binary)
+            : PQsendQueryParams(conn, st.sql.c_str(), st.params.size(), nullptr, param_values.data(), nullptr, nullptr, st.binary);
+        if (!sent) {
+            op.error = PQerrorMessage(conn);
+            break;
+        }
+        op.commands.push_back(-1);
+    }
+    // Без Sync результатів не буде взагалі - тоді операцію завершуємо одразу.
+    if (!PQpipelineSync(conn)) {
+        if (op.error.empty()) op.error = PQerrorMessage(conn);
+        return false;
+    }
+    op.synced = true;
+
+    int flushed = PQflush(conn);
+    if (flushed < 0) {
+        if (op.error.empty()) op.error = PQerrorMessage(conn);
+        return false;
+    }
+    op.want_write = flushed == 1;
+
+    uint32_t events = EPOLLIN;
+    if (op.want_write) events |= EPOLLOUT;
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.ptr = &op;
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, PQsocket(conn), &ev) != 0) {
+        if (op.error.empty()) op.error = "PgLoop: epoll_ctl failed.";
+        return false;
+    }
+    return true;
+}
+
+void PgLoop::on_ready(Op* op, uint32_t events) {
+    PGconn* conn = op->pgConn->conn;
+
+    if (op->want_write && (events & EPOLLOUT)) {
+        int flushed = PQflush(conn);
+        if (flushed < 0) {
+            if (op->error.empty()) op->error = PQerrorMessage(conn);
+            finish(op);
+            return;
+        }
+        if (flushed == 0) {
+            op->want_write = false;
+            epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.ptr = op;
+            epoll_ctl(epfd, EPOLL_CTL_MOD, PQsocket(conn), &ev);
+        }
+    }
+
+    if (!(events & (EPOLLIN | EPOLLERR | EPOLLHUP))) return;
+
+    if (!PQconsumeInput(conn)) {
+        if (op->error.empty()) op->error = PQerrorMessage(conn);
+        finish(op);
+        return;
+    }
+
+    while (!PQisBusy(conn)) {
+        PGresult* res = PQgetResult(conn);
+        if (!res) {
+            // Розділювач між командами; більше, ніж команд, - значить чекаємо на дані.
+            if (++op->separators > op->commands.size()) break;
+            continue;
+        }
+        ExecStatusType status = PQresultStatus(res);
+        if (status == PGRES_PIPELINE_SYNC) {
+            PQclear(res);
+            finish(op);
+            return;
+        }
+        if (status == PGRES_TUPLES_OK || status == PGRES_COMMAND_OK) {
+            // Результат команди з номером separators; Prepare у результати запитів не входить
+            const int prepare = op->separators < op->commands.size() ? op->commands[op->separators] : -1;
+            if (prepare >= 0) {
+                auto& p = op->prepares[prepare];
+                p.done = true;
+                p.time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - op->sent_at);
+                PQclear(res);
+                continue;
+            }
+            op->results.push_back(res);
+            continue;
+        }
+        if (op->error.empty()) {
+            op->error = status == PGRES_PIPELINE_ABORTED ? "Pipeline aborted." : PQresultErrorMessage(res);
+        }
+        PQclear(res);
+    }
+}
+
+void PgLoop::finish(Op* op) {
+    PGconn* conn = op->pgConn->conn;
+    epoll_ctl(epfd, EPOLL_CTL_DEL, PQsocket(conn), nullptr);
+    // Після помилки (відправка, flush, epoll) результати пакета можуть лишатись невичитаними.
+    // leave_pipeline() дочитує їх блокуюче - лише на шляху помилки; якщо з'єднання
+    // так і лишилось у pipeline mode, release() його закриє, а не віддасть наступному.
+    if (!op->pgConn->leave_pipeline(op->synced) && op->error.empty()) {
+        op->error = "PgLoop: failed to leave pipeline mode: " + std::string(PQerrorMessage(conn));
+    }
+    PQsetnonblocking(conn, 0);
+    // Підготовлені пакетом оператори - в кеш з'єднання. Лише тут: витіснення закриває
+    // старий оператор синхронно, а в pipeline mode це неможливо.
+    if (op->pgConn->reusable()) {
+        for (auto& p : op->prepares) {
+            if (!p.done) continue;
+            const double cost = static_cast<double>(std::max<int64_t>(1, p.time.count()));
+            op->pgConn->cache.put(p.sql, PgPrepStmt(PgPrepStmt::Adopt{}, conn, std::move(p.name), p.time), cost);
+        }
+    }
+    pool.release(op->pgConn);
+
+    auto it = active.find(op);
+    std::unique_ptr<Op> owned = std::move(it->second);
+    active.erase(it);
+
+    if (!owned->error.empty()) {
+        for (PGresult* res : owned->results) PQclear(res);
+        owned->results.clear();
+    }
+    owned->done(std::move(owned->results), owned->error);
+}
+
@@ -3,6 +3,7 @@
 #include "arc.h" // Ваш файл з реалізацією AdaptiveReplacementCache
 #include <postgresql/libpq-fe.h>
 #include <string>
+#include <string_view>
 #include <chrono>
 #include <memory>
 #include <vector>
@@ -11,20 +12,33 @@
 #include <condition_variable>
 #include <stdexcept>
 #include <atomic>
+#include <thread>
+#include <deque>
+#include <functional>
+#include <unordered_map>
 
 
 struct PgPrepStmt {
     PGconn* conn;
     std::string stmtName;
+    std::chrono::microseconds prepareTime{0};  // Скільки тривав PQprepare - вартість для кешу
 
 private:
     static inline std::atomic<int> counter{0};
 
 public:
+    /// Унікальне ім'я нового оператора.
+    static std::string next_name() { return "pg_prep_stmt_" + std::to_string(++counter); }
+
     PgPrepStmt() : conn(nullptr) {}
 
+    /// Оператор, вже підготовлений на conn під іменем name (PQsendPrepare у pipeline PgLoop).
+    struct Adopt {};
+    PgPrepStmt(Adopt, PGconn* c, std::string name, std::chrono::microseconds prepareTime)
+        : conn(c), stmtName(std::move(name)), prepareTime(prepareTime) {}
+
     PgPrepStmt(PGconn* c, const std::string& query)
-        : conn(c), stmtName("pg_prep_stmt_" + std::to_string(++counter)) {
+        : conn(c), stmtName(next_name()) {
         if (!conn) {
             throw std::invalid_argument("Connection pointer is null.");
         }
@@ -32,7 +46,9 @@ public:
             throw std::invalid_argument("Query cannot be empty.");
         }
 
+        const auto started = std::chrono::steady_clock::now();
         PGresult* res = PQprepare(conn, stmtName.c_str(), query.c_str(), 0, nullptr);
+        prepareTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started);
 
         if (PQresultStatus(res) != PGRES_COMMAND_OK) {
              std::string errorMsg = PQerrorMessage(conn);
@@ -54,7 +70,7 @@ public:
     PgPrepStmt& operator=(const PgPrepStmt& other) = delete;
 
     PgPrepStmt(PgPrepStmt&& other) noexcept
-        : conn(other.conn), stmtName(std::move(other.stmtName)) {
+        : conn(other.conn), stmtName(std::move(other.stmtName)), prepareTime(other.prepareTime) {
         other.conn = nullptr;
         other.stmtName.clear();
     }
@@ -67,6 +83,7 @@ public:
 
             conn = other.conn;
             stmtName = std::move(other.stmtName);
+            prepareTime = other.prepareTime;
 
             other.conn = nullptr;
             other.stmtName.clear();
@@ -78,22 +95,40 @@ public:
 // Структура, що об'єднує з'єднання та його персональний кеш
 struct PgConn {
     static int arc_hard_limit;
+    // Recency - витіснення без урахування часу PQprepare, як до cost-aware кешу
+    static ArcEvictionPolicy arc_policy;
 
     PGconn* conn = nullptr;
-    AdaptiveReplacementCache<PgPrepStmt> cache;
+    // ARC з тінями: звіти, що готуються один раз, не витісняють гарячі OLTP-запити
+    AdaptiveReplacementCache<PgPrepStmt, ArcTrue> cache;
     std::chrono::steady_clock::time_point last_released_time;
 
     PgConn(const std::string& connInfo);
     ~PgConn();
 
+    /// Виводить з'єднання з pipeline mode: відправляє Sync, якщо synced == false,
+    /// дочитує результати до PGRES_PIPELINE_SYNC і перевіряє PQexitPipelineMode.
+    /// Лишає з'єднання в блокуючому режимі.
+    /// @return false - стан з'єднання невизначений, в пул його не повертають (PgPool::release закриє).
+    bool leave_pipeline(bool synced);
+    /// Чи можна віддати з'єднання наступному користувачу: відкрите, не в pipeline mode,
+    /// блокуюче, без незавершеної транзакції.
+    bool reusable() const;
+
     PgConn(const PgConn&) = delete;
     PgConn& operator=(const PgConn&) = delete;
 };
 
 
 // Клас динамічного пулу з'єднань
+// Нові з'єднання відкриває фоновий потік за попитом: коли є потоки, що чекають,
+// або забрали останнє вільне з'єднання. Жоден виклик acquire() не платить за PQconnectdb.
+// Вільні з'єднання розкладено по шардах: потік бере і повертає з'єднання у "свій" шард
+// і краде з чужих, лише коли свій порожній. Спільний м'ютекс потрібен тільки для
+// очікування, росту та прибирання простою, яке теж робить фоновий потік.
 class PgPool {
 public:
+    /// @param growthTimeout Пауза фонового росту після невдалої спроби з'єднання.
     PgPool(std::string connInfo, size_t hardLimit, 
          std::chrono::seconds growthTimeout, std::chrono::seconds idleTimeout);
     ~PgPool();
@@ -101,13 +136,55 @@ public:
     PgPool(const PgPool&) = delete;
     PgPool& operator=(const PgPool&) = delete;
 
+    struct Stats {
+        uint64_t affinity_hits = 0;    // acquire(sql) віддав з'єднання, де запит вже підготовлений
+        uint64_t affinity_misses = 0;  // такого вільного з'єднання не знайшлось
+        uint64_t acquires = 0;
+        size_t total = 0;       // відкриті з'єднання
+        size_t available = 0;   // з них вільні
+        size_t waiters = 0;     // глибина черги: потоки, що зараз чекають у acquire()
+        size_t pending = 0;     // з'єднання, що саме відкриваються у фоні
+        uint32_t wait_p50_us = 0;  // перцентилі очікування в acquire()
+        uint32_t wait_p99_us = 0;  // за останні wait_samples_size викликів кожного шарду
+    };
+
     PgConn* acquire();
+    /// Віддає перевагу вільному з'єднанню, в кеші якого вже є підготовлений sql.
+    PgConn* acquire(std::string_view sql);
+    /// Як acquire(sql), але не чекає: nullptr, якщо вільних з'єднань немає.
+    PgConn* try_acquire(std::string_view sql = {});
+    /// Повертає з'єднання в пул; з'єднання, що не reusable(), закриває (discard).
     void release(PgConn* pgConn);
+    /// Закриває з'єднання замість повернення в пул; фоновий потік відкриє заміну за попитом.
+    void discard(PgConn* pgConn);
+
+    /// Хук, який release() викликає, поки want_release(true): так PgLoop, що чекає
+    /// на вільне з'єднання, прокидається без опитування. Один на пул; nullptr - прибрати.
+    void set_release_hook(std::function<void()> hook);
+    void want_release(bool want) { release_wanted.store(want); }
     
+    Stats stats() const;
     void print_stats() const;
 
 private:
+    static constexpr size_t wait_samples_size = 1024;
+
+    struct alignas(64) Shard {
+        mutable std::mutex mutex;
+        std::list<PgConn*> available;
+        std::vector<uint32_t> wait_samples;  // кільцевий буфер, мкс
+        size_t wait_samples_next = 0;
+    };
+
+    size_t home_shard() const;
+    PgConn* take(std::string_view sql);
+    void push_idle(Shard& shard, PgConn* pgConn);
+    void signal_growth();
+    void record_wait(Shard& shard, std::chrono::steady_clock::duration waited);
     void print_stats_unlocked() const;
+    bool need_growth_unlocked() const;
+    void maintenance_loop();
+    void reap_idle_unlocked(std::vector<std::unique_ptr<PgConn>>& reaped);
 
 
     std::string connInfo;
@@ -116,11 +193,27 @@ private:
     std::chrono::seconds idleTimeout;
     const size_t minLimit = 1;
 
+    const size_t shard_count;
+    std::unique_ptr<Shard[]> shards;
+    size_t next_grow_shard = 0;  // під mutex
+
+    std::atomic<size_t> idle_count{0};
+    std::atomic<size_t> waiters{0};
+    std::atomic<uint64_t> affinity_hits{0};
+    std::atomic<uint64_t> affinity_misses{0};
+    std::atomic<uint64_t> acquires{0};
+    std::atomic<bool> release_wanted{false};
+
+    // --- Під mutex ---
+    std::function<void()> release_hook;
     std::vector<std::unique_ptr<PgConn>> storage;
-    std::list<PgConn*> available;
-    
+    size_t pending = 0;
+    bool stopping = false;
+
     mutable std::mutex mutex;
-    std::condition_variable cv;
+    std::condition_variable cv;       // вільне з'єднання з'явилось
+    std::condition_variable grow_cv;  // є попит на нове з'єднання або зупинка
+    std::thread maintainer;
 };
 
 
@@ -128,6 +221,10 @@ private:
 class PgPoolRaii {
 public:
     explicit PgPoolRaii(PgPool& pool);
+    PgPoolRaii(PgPool& pool, std::string_view sql);
+    /// pinned - з'єднання відкритої транзакції: береться як є і в пул не повертається.
+    /// nullptr - як PgPoolRaii(pool, sql).
+    PgPoolRaii(PgPool& pool, PgConn* pinned, std::string_view sql = {});
     ~PgPoolRaii();
 
     PgPoolRaii(const PgPoolRaii&) = delete;
@@ -139,4 +236,70 @@ public:
 private:
     PgPool& pool;
     PgConn* pgConn;
+    bool owned = true;
+};
+
+
+// Цикл подій для асинхронних запитів: один потік веде сокети всіх зайнятих ним з'єднань
+// через epoll, тож сотні запитів у польоті не потребують окремого потоку кожен.
+// Кожна операція - пакет запитів у pipeline mode на одному з'єднанні пулу.
+class PgLoop {
+public:
+    struct Stmt {
+        std::string sql;
+        std::vector<std::string> params;
+        bool once = false;    // без кешу підготовлених запитів
+        bool binary = false;  // бінарний формат результату
+    };
+    // Викликається в потоці циклу. Власність PGresult переходить до отримувача.
+    // При помилці results порожній, а error містить її текст.
+    using done_t = std::function<void(std::vector<PGresult*>&& results, const std::string& error)>;
+
+    explicit PgLoop(PgPool& pool);
+    ~PgLoop();
+
+    PgLoop(const PgLoop&) = delete;
+    PgLoop& operator=(const PgLoop&) = delete;
+
+    void submit(std::vector<Stmt> stmts, done_t done);
+
+private:
+    struct Op {
+        std::vector<Stmt> stmts;
+        done_t done;
+        PgConn* pgConn = nullptr;
+        std::vector<PGresult*> results;
+        std::string error;
+        size_t separators = 0;  // NULL від PQgetResult між результатами команд
+        // Промахи кешу: PQsendPrepare перед першим запитом з цим sql; в кеш - у finish()
+        struct Prepare {
+            std::string sql;
+            std::string name;
+            bool done = false;
+            std::chrono::microseconds time{0};  // від відправки пакета до відповіді на Prepare
+        };
+        std::vector<Prepare> prepares;
+        std::vector<int> commands;  // відправлені команди: індекс у prepares або -1 - запит
+        std::chrono::steady_clock::time_point sent_at;
+        bool synced = false;    // PQpipelineSync відправлено
+        bool want_write = false;
+    };
+
+    void run();
+    void start_queued();
+    bool send(Op& op);
+    void on_ready(Op* op, uint32_t events);
+    void finish(Op* op);
+    void wake();
+
+    PgPool& pool;
+    int epfd = -1;
+    int wakefd = -1;
+
+    std::mutex queue_mutex;
+    std::deque<std::unique_ptr<Op>> queued;  // чекають на вільне з'єднання
+    bool stopping = false;
+
+    std::unordered_map<Op*, std::unique_ptr<Op>> active;  // лише потік циклу
+    std::thread worker;
 };
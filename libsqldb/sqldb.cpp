@@ -1,4 +1,5 @@
 #include "rack.h"
+#include <algorithm>
 
 // Підключаємо заголовки всіх реалізацій драйверів
 #include "sqldrvpg.h"
@@ -28,4 +29,115 @@ bool Rack::connect(sv connection_string) {
     return true; // або результат реального підключення
 }
 
+SqlDB::ImportReport SqlDB::bulk_import(sv table, const std::vector<ImportColumn>& columns,
+                                       const std::vector<ImportRow>& rows, size_t batch_rows) {
+    ImportReport report;
+    if (batch_rows == 0) batch_rows = rows.size();
+    std::vector<bool> valid;
+    std::vector<const ImportRow*> batch;
+    std::vector<size_t> index;
+    for (size_t first = 0; first < rows.size(); first += batch_rows) {
+        const size_t last = std::min(rows.size(), first + batch_rows);
+        valid.assign(last - first, true);
+
+        for (size_t i = first; i < last; ++i) {
+            if (rows[i].size() != columns.size()) {
+                valid[i - first] = false;
+                report.errors.push_back({i, {}, "expected " + std::to_string(columns.size()) + " values, got " +
+                                                    std::to_string(rows[i].size())});
+            }
+        }
+        // Поколонково: один тип на весь прохід порції
+        for (size_t col = 0; col < columns.size(); ++col) {
+            const type_t& type = *columns[col].type;
+            // Нетипізовані колонки (timestamp, numeric...) перевірить сервер
+            if (type.bin() == type_t::bin_t::none) continue;
+            const bool text = type.bin() == type_t::bin_t::text;
+            for (size_t i = first; i < last; ++i) {
+                if (!valid[i - first]) continue;
+                const optsv& v = rows[i][col];
+                if (!v || (!text && v->empty())) continue;  // NULL
+                if (!type.validate(*v)) {
+                    valid[i - first] = false;
+                    report.errors.push_back({i, columns[col].name, "invalid " + type.name + " value: " + string(*v)});
+                }
+            }
+        }
+
+        batch.clear();
+        index.clear();
+        for (size_t i = first; i < last; ++i) {
+            if (!valid[i - first]) continue;
+            batch.push_back(&rows[i]);
+            index.push_back(i);
+        }
+        if (!batch.empty()) import_bisect(table, columns, batch, index, report);
+    }
+    return report;
+}
+
+size_t SqlDB::import_batch(sv table, const std::vector<ImportColumn>& columns,
+                           const std::vector<const ImportRow*>& rows) {
+    string sql = "INSERT INTO " + string(table) + " (";
+    for (size_t col = 0; col < columns.size(); ++col) {
+        if (col) sql += ", ";
+        sql += columns[col].name;
+    }
+    sql += ") VALUES ";
+    std::vector<string> params;
+    params.reserve(rows.size() * columns.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+        sql += i ? ", (" : "(";
+        for (size_t col = 0; col < columns.size(); ++col) {
+            const optsv& v = (*rows[i])[col];
+            const bool is_null = !v || (columns[col].type->bin() != type_t::bin_t::text && v->empty());
+            if (col) sql += ", ";
+            if (is_null) {
+                sql += "NULL";
+            } else {
+                params.emplace_back(*v);
+                sql += "$" + std::to_string(params.size());
+            }
+        }
+        sql += ")";
+    }
+    return execute(sql, params);
+}
+
+size_t SqlDB::import_attempt(sv table, const std::vector<ImportColumn>& columns,
+                             const std::vector<const ImportRow*>& rows) {
+    // Помилка запиту перериває всю транзакцію - відкочуємо лише цю спробу
+    const bool savepoint = inTransaction();
+    if (savepoint) execute("SAVEPOINT ky_bulk_import", {});
+    try {
+        const size_t imported = import_batch(table, columns, rows);
+        if (savepoint) execute("RELEASE SAVEPOINT ky_bulk_import", {});
+        return imported;
+    } catch (...) {
+        if (savepoint) execute("ROLLBACK TO SAVEPOINT ky_bulk_import", {});
+        throw;
+    }
+}
+
+void SqlDB::import_bisect(sv table, const std::vector<ImportColumn>& columns,
+                          const std::vector<const ImportRow*>& rows, const std::vector<size_t>& index,
+                          ImportReport& report) {
+    try {
+        report.imported += import_attempt(table, columns, rows);
+        return;
+    } catch (const Error& e) {
+        // Поділ допомагає лише проти поганих рядків; решта помилок повторилась би 2n - 1 разів
+        if (!e.rowsRejected()) throw;
+        if (rows.size() == 1) {
+            report.errors.push_back({index.front(), {}, e.what()});
+            return;
+        }
+    }
+    // k поганих рядків коштують O(k log n) повторних спроб замість звіту про всю порцію
+    const size_t half = rows.size() / 2;
+    import_bisect(table, columns, {rows.begin(), rows.begin() + half}, {index.begin(), index.begin() + half},
+                  report);
+    import_bisect(table, columns, {rows.begin() + half, rows.end()}, {index.begin() + half, index.end()}, report);
+}
+
 } // namespace ky
\ No newline at end of file
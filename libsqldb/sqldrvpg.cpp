@@ -1,4 +1,5 @@
 #include "sqldrvpg.h"
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
 
@@ -33,30 +34,98 @@ ky::optsv SqlDrvPg::Result::get_value(int row, int col) const {
     return ky::optsv(sv(PQgetvalue(res, row, col), PQgetlength(res, row, col)));
 }
 
+namespace {
+// Бінарний формат PostgreSQL - big-endian.
+int64_t read_be(const char* p, int len) {
+    uint64_t v = 0;
+    for (int i = 0; i < len; ++i) {
+        v = (v << 8) | static_cast<uint8_t>(p[i]);
+    }
+    // Розширення знаку для int2/int4
+    if (len < 8 && len > 0 && (v >> (len * 8 - 1)) & 1) {
+        v |= ~uint64_t{0} << (len * 8);
+    }
+    return static_cast<int64_t>(v);
+}
+} // namespace
+
+std::optional<int32_t> SqlDrvPg::Result::get_int32(int row, int col) const {
+    if (!is_binary(col)) return SqlDB::Result::get_int32(row, col);
+    if (PQgetisnull(res, row, col)) return std::nullopt;
+    int len = PQgetlength(res, row, col);
+    if (len != 2 && len != 4) {
+        throw std::runtime_error("get_int32: unexpected binary length " + std::to_string(len));
+    }
+    return static_cast<int32_t>(read_be(PQgetvalue(res, row, col), len));
+}
+
+std::optional<int64_t> SqlDrvPg::Result::get_int64(int row, int col) const {
+    if (!is_binary(col)) return SqlDB::Result::get_int64(row, col);
+    if (PQgetisnull(res, row, col)) return std::nullopt;
+    int len = PQgetlength(res, row, col);
+    if (len != 2 && len != 4 && len != 8) {
+        throw std::runtime_error("get_int64: unexpected binary length " + std::to_string(len));
+    }
+    return read_be(PQgetvalue(res, row, col), len);
+}
+
+std::optional<date_t> SqlDrvPg::Result::get_date(int row, int col) const {
+    if (!is_binary(col)) return SqlDB::Result::get_date(row, col);
+    if (PQgetisnull(res, row, col)) return std::nullopt;
+    if (PQgetlength(res, row, col) != 4) {
+        throw std::runtime_error("get_date: unexpected binary length");
+    }
+    // Бінарний DATE - int4, кількість днів від 2000-01-01
+    using namespace std::chrono;
+    static constexpr date_t pg_epoch = sys_days{year{2000} / January / 1};
+    return pg_epoch + days{read_be(PQgetvalue(res, row, col), 4)};
+}
+
 // --- SqlDrvPg ---
 
 SqlDrvPg::SqlDrvPg(sv connection_string)
     // Ініціалізуємо пул напряму в списку ініціалізації.
     // TODO: параметри пулу (hardLimit, timeouts) слід винести в конфігурацію.
-    : pool(string(connection_string), 10, std::chrono::seconds(5), std::chrono::seconds(60)) {}
+    : pool(string(connection_string), 10, std::chrono::seconds(1), std::chrono::seconds(60)) {}
 
 SqlDrvPg::~SqlDrvPg() = default;
 
-std::unique_ptr<SqlDB::Result> SqlDrvPg::query(sv sql, const std::vector<string>& params) {
-    PgPoolRaii conn_guard(pool);
-    PgConn* pg_conn = conn_guard.get();
-
-    // Використовуємо кеш підготовлених запитів, що прив'язаний до конкретного з'єднання.
-    PgPrepStmt* stmt = pg_conn->cache.get(string(sql));
-    if (!stmt) {
-        stmt = pg_conn->cache.put(string(sql), PgPrepStmt(pg_conn->conn, string(sql)));
-    }
+namespace {
+// SQLSTATE помилки з результату; порожній - помилка клієнта (з'єднання, libpq)
+string sqlstate(const PGresult* res) {
+    const char* code = res ? PQresultErrorField(res, PG_DIAG_SQLSTATE) : nullptr;
+    return code ? code : "";
+}
 
+// Масив вказівників для libpq; живе не довше за params.
+std::vector<const char*> c_params(const std::vector<string>& params) {
     std::vector<const char*> param_values;
     param_values.reserve(params.size());
     for (const auto& p : params) {
         param_values.push_back(p.c_str());
     }
+    return param_values;
+}
+} // namespace
+
+PgPrepStmt* SqlDrvPg::prepare(PgConn* pg_conn, const ArcKey& sql) {
+    // Використовуємо кеш підготовлених запитів, що прив'язаний до конкретного з'єднання.
+    PgPrepStmt* stmt = pg_conn->cache.get(sql);
+    if (!stmt) {
+        PgPrepStmt prepared(pg_conn->conn, string(sql.view));
+        // Вартість запису - час PQprepare: складні JOIN-и дорожче готувати заново
+        const double cost = static_cast<double>(std::max<int64_t>(1, prepared.prepareTime.count()));
+        stmt = pg_conn->cache.put(sql, std::move(prepared), cost);
+    }
+    return stmt;
+}
+
+std::unique_ptr<SqlDB::Result> SqlDrvPg::query(sv sql, const std::vector<string>& params) {
+    PgPoolRaii conn_guard(pool, tx_conn(), sql);
+    PgConn* pg_conn = conn_guard.get();
+
+    PgPrepStmt* stmt = prepare(pg_conn, sql);
+    auto param_values = c_params(params);
 
     PGresult* res = PQexecPrepared(pg_conn->conn, stmt->stmtName.c_str(), params.size(), param_values.data(), nullptr, nullptr, 0);
 
@@ -69,22 +138,224 @@ std::unique_ptr<SqlDB::Result> SqlDrvPg::query(sv sql, const std::vector<string>
     return std::make_unique<Result>(res);
 }
 
-int SqlDrvPg::execute(sv sql, const std::vector<string>& params) {
-    PgPoolRaii conn_guard(pool);
+std::unique_ptr<SqlDB::Result> SqlDrvPg::query_once(sv sql, const std::vector<string>& params) {
+    PgPoolRaii conn_guard(pool, tx_conn());
     PgConn* pg_conn = conn_guard.get();
 
-    std::vector<const char*> param_values;
-    param_values.reserve(params.size());
-    for (const auto& p : params) {
-        param_values.push_back(p.c_str());
+    auto param_values = c_params(params);
+
+    PGresult* res = PQexecParams(pg_conn->conn, string(sql).c_str(), params.size(), nullptr, param_values.data(), nullptr, nullptr, 0);
+
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        string error_msg = PQerrorMessage(pg_conn->conn);
+        PQclear(res);
+        throw std::runtime_error(error_msg);
+    }
+
+    return std::make_unique<Result>(res);
+}
+
+std::vector<std::unique_ptr<SqlDB::Result>> SqlDrvPg::query_pipeline(const std::vector<Statement>& batch) {
+    std::vector<std::unique_ptr<SqlDB::Result>> results;
+    if (batch.empty()) return results;
+
+    // Спорідненість обираємо за першим кешованим запитом пакета
+    auto hot = std::find_if(batch.begin(), batch.end(), [](const Statement& st) { return !st.once; });
+    PgPoolRaii conn_guard(pool, tx_conn(), hot != batch.end() ? hot->sql : sv{});
+    PgConn* pg_conn = conn_guard.get();
+    PGconn* conn = pg_conn->conn;
+
+    // PQprepare синхронний, тому промахи кешу готуємо ДО входу в pipeline.
+    // Для гарячих запитів це нуль додаткових обмінів.
+    // Підготовлені закріплюємо: інакше put() наступного запиту пакета міг би витіснити
+    // (і закрити на сервері) попередній ще до PQsendQueryPrepared.
+    std::vector<const PgPrepStmt*> stmts(batch.size(), nullptr);
+    std::vector<ArcKey> pinned;
+    struct Unpin {
+        PgConn* pg_conn;
+        std::vector<ArcKey>& keys;
+        ~Unpin() {
+            for (const ArcKey& key : keys) pg_conn->cache.unpin(key);
+        }
+    } unpin{pg_conn, pinned};
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (batch[i].once) continue;
+        const ArcKey key(batch[i].sql);  // один хеш на get/put/pin/unpin
+        stmts[i] = prepare(pg_conn, key);
+        if (pg_conn->cache.pin(key)) pinned.push_back(key);
+    }
+
+    if (!PQenterPipelineMode(conn)) {
+        throw std::runtime_error("PQenterPipelineMode failed: " + string(PQerrorMessage(conn)));
+    }
+
+    string error_msg;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        const auto& st = batch[i];
+        auto param_values = c_params(st.params);
+        int sent = stmts[i]
+            ? PQsendQueryPrepared(conn, stmts[i]->stmtName.c_str(), st.params.size(), param_values.data(), nullptr, nullptr, st.binary)
+            : PQsendQueryParams(conn, string(st.sql).c_str(), st.params.size(), nullptr, param_values.data(), nullptr, nullptr, st.binary);
+        if (!sent) {
+            error_msg = PQerrorMessage(conn);
+            break;
+        }
+    }
+
+    // Sync завершує неявну транзакцію пакета і змушує libpq відправити все одним обміном.
+    bool synced = PQpipelineSync(conn);
+    if (!synced && error_msg.empty()) {
+        error_msg = PQerrorMessage(conn);
+    }
+
+    // Вичитуємо все до PGRES_PIPELINE_SYNC, навіть після помилки,
+    // щоб повернути з'єднання в пул у чистому стані.
+    // NULL від PQgetResult розділяє результати окремих запитів.
+    results.reserve(batch.size());
+    while (synced && PQstatus(conn) == CONNECTION_OK) {
+        PGresult* res = PQgetResult(conn);
+        if (!res) continue;
+
+        ExecStatusType status = PQresultStatus(res);
+        if (status == PGRES_PIPELINE_SYNC) {
+            PQclear(res);
+            break;
+        }
+        if (status == PGRES_TUPLES_OK || status == PGRES_COMMAND_OK) {
+            results.push_back(std::make_unique<Result>(res));
+            continue;
+        }
+        // PGRES_PIPELINE_ABORTED приходить для запитів після першої помилки - її і повідомляємо.
+        if (error_msg.empty()) {
+            error_msg = status == PGRES_PIPELINE_ABORTED ? "Pipeline aborted." : PQresultErrorMessage(res);
+        }
+        PQclear(res);
+    }
+
+    if (PQstatus(conn) != CONNECTION_OK && error_msg.empty()) {
+        error_msg = PQerrorMessage(conn);
+    }
+    // Якщо вийти не вдалось, conn_guard не поверне з'єднання в пул, а закриє (PgPool::release)
+    if (!pg_conn->leave_pipeline(synced) && error_msg.empty()) {
+        error_msg = "Failed to leave pipeline mode: " + string(PQerrorMessage(conn));
+    }
+
+    if (!error_msg.empty()) {
+        throw std::runtime_error(error_msg);
+    }
+    return results;
+}
+
+std::unique_ptr<SqlDB::Stream> SqlDrvPg::query_stream(sv sql, const std::vector<string>& params, int chunk_rows) {
+    return std::make_unique<Stream>(pool, tx_conn(), sql, params, chunk_rows);
+}
+
+// --- SqlDrvPg::Stream ---
+
+SqlDrvPg::Stream::Stream(PgPool& pool, PgConn* pinned, sv sql, const std::vector<string>& params, int chunk_rows)
+    : conn_guard(pool, pinned, sql), chunk_rows(std::max(1, chunk_rows)) {
+    PgConn* pg_conn = conn_guard.get();
+    PgPrepStmt* stmt = prepare(pg_conn, sql);
+    auto param_values = c_params(params);
+
+    if (!PQsendQueryPrepared(pg_conn->conn, stmt->stmtName.c_str(), params.size(), param_values.data(), nullptr, nullptr, 0)) {
+        throw std::runtime_error(PQerrorMessage(pg_conn->conn));
+    }
+
+    // Якщо режим не встановився, результат просто прийде однією порцією.
+#ifdef LIBPQ_HAS_CHUNK_MODE
+    PQsetChunkedRowsMode(pg_conn->conn, this->chunk_rows);
+#else
+    // libpq < 17: порції до chunk_rows рядків збирає next_chunk()
+    PQsetSingleRowMode(pg_conn->conn);
+#endif
+}
+
+SqlDrvPg::Stream::~Stream() {
+    if (done) return;
+    // Потік кинули недочитаним: скасовуємо запит на сервері, щоб не тягнути решту рядків.
+    PGconn* conn = conn_guard->conn;
+    if (PGcancel* cancel = PQgetCancel(conn)) {
+        char errbuf[256];
+        PQcancel(cancel, errbuf, sizeof(errbuf));
+        PQfreeCancel(cancel);
+    }
+    drain();
+}
+
+void SqlDrvPg::Stream::drain() {
+    while (PGresult* res = PQgetResult(conn_guard->conn)) {
+        PQclear(res);
+    }
+    done = true;
+}
+
+namespace {
+// Дописує рядок 0 результату row в кінець chunk; false - не вистачило пам'яті.
+bool append_row(PGresult* chunk, const PGresult* row) {
+    const int n = PQntuples(chunk);
+    for (int col = 0; col < PQnfields(row); ++col) {
+        // len -1 - NULL
+        const int len = PQgetisnull(row, 0, col) ? -1 : PQgetlength(row, 0, col);
+        if (!PQsetvalue(chunk, n, col, PQgetvalue(row, 0, col), len)) return false;
     }
+    return true;
+}
+} // namespace
+
+std::unique_ptr<SqlDB::Result> SqlDrvPg::Stream::next_chunk() {
+    if (done) return nullptr;
+
+    // Single-row mode віддає PGresult на кожен рядок - збираємо їх у порцію до chunk_rows
+    PGresult* chunk = nullptr;
+    while (PGresult* res = PQgetResult(conn_guard->conn)) {
+        const ExecStatusType status = PQresultStatus(res);
+#ifdef LIBPQ_HAS_CHUNK_MODE
+        if (status == PGRES_TUPLES_CHUNK) return std::make_unique<Result>(res);
+#endif
+        if (status == PGRES_SINGLE_TUPLE) {
+            if (!chunk) chunk = PQcopyResult(res, PG_COPYRES_ATTRS);
+            const bool appended = chunk && append_row(chunk, res);
+            PQclear(res);
+            if (!appended) {
+                if (chunk) PQclear(chunk);
+                drain();
+                throw std::runtime_error("Stream: out of memory while building a chunk.");
+            }
+            if (PQntuples(chunk) >= chunk_rows) return std::make_unique<Result>(chunk);
+            continue;
+        }
+        if (status == PGRES_TUPLES_OK) {
+            // Завершальний результат: порожній у режимі порцій, або весь результат,
+            // якщо режим порцій не встановився.
+            drain();
+            if (!chunk && PQntuples(res) > 0) return std::make_unique<Result>(res);
+            PQclear(res);
+            break;
+        }
+        string error_msg = PQresultErrorMessage(res);
+        PQclear(res);
+        if (chunk) PQclear(chunk);
+        drain();
+        throw std::runtime_error(error_msg);
+    }
+    done = true;
+    return chunk ? std::make_unique<Result>(chunk) : nullptr;
+}
+
+int SqlDrvPg::execute(sv sql, const std::vector<string>& params) {
+    PgPoolRaii conn_guard(pool, tx_conn());
+    PgConn* pg_conn = conn_guard.get();
+
+    auto param_values = c_params(params);
 
     PGresult* res = PQexecParams(pg_conn->conn, string(sql).c_str(), params.size(), nullptr, param_values.data(), nullptr, nullptr, 0);
 
     if (PQresultStatus(res) != PGRES_COMMAND_OK) {
         string error_msg = PQerrorMessage(pg_conn->conn);
+        string code = sqlstate(res);
         PQclear(res);
-        throw std::runtime_error(error_msg);
+        throw Error(error_msg, std::move(code));
     }
 
     string tuples = PQcmdTuples(res);
@@ -92,4 +363,289 @@ int SqlDrvPg::execute(sv sql, const std::vector<string>& params) {
     return tuples.empty() ? 0 : std::stoi(tuples);
 }
 
+// --- Транзакції ---
+
+PgConn* SqlDrvPg::tx_conn() const {
+    if (tx_open.load() == 0) return nullptr;  // Без транзакцій м'ютекс не чіпаємо
+    std::lock_guard<std::mutex> lock(tx_mutex);
+    auto it = tx_conns.find(std::this_thread::get_id());
+    return it != tx_conns.end() ? it->second : nullptr;
+}
+
+namespace {
+// Повертає тег команди (PQcmdStatus), напр. "COMMIT".
+string exec_command(PGconn* conn, const char* sql) {
+    PGresult* res = PQexec(conn, sql);
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        string error_msg = PQerrorMessage(conn);
+        PQclear(res);
+        throw std::runtime_error(error_msg);
+    }
+    string tag = PQcmdStatus(res);
+    PQclear(res);
+    return tag;
+}
+} // namespace
+
+void SqlDrvPg::beginTransaction() {
+    if (tx_conn()) {
+        throw std::runtime_error("SqlDrvPg: nested transactions are not supported.");
+    }
+    PgConn* pg_conn = pool.acquire();
+    try {
+        exec_command(pg_conn->conn, "BEGIN");
+    } catch (...) {
+        pool.release(pg_conn);
+        throw;
+    }
+    std::lock_guard<std::mutex> lock(tx_mutex);
+    tx_conns.emplace(std::this_thread::get_id(), pg_conn);
+    ++tx_open;
+}
+
+void SqlDrvPg::commit() {
+    // Для транзакції з помилкою сервер відповідає на COMMIT тегом ROLLBACK без помилки
+    if (end_transaction("COMMIT") != "COMMIT") {
+        throw std::runtime_error("SqlDrvPg: transaction was rolled back by the server.");
+    }
+}
+
+void SqlDrvPg::rollback() {
+    end_transaction("ROLLBACK");
+}
+
+bool SqlDrvPg::inTransaction() const {
+    return tx_conn() != nullptr;
+}
+
+string SqlDrvPg::end_transaction(const char* sql) {
+    PgConn* pg_conn = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(tx_mutex);
+        auto it = tx_conns.find(std::this_thread::get_id());
+        if (it == tx_conns.end()) {
+            throw std::runtime_error(string("SqlDrvPg: ") + sql + " without an open transaction.");
+        }
+        pg_conn = it->second;
+        tx_conns.erase(it);
+        --tx_open;
+    }
+    // З'єднання повертається в пул за будь-якого результату команди
+    try {
+        string tag = exec_command(pg_conn->conn, sql);
+        pool.release(pg_conn);
+        return tag;
+    } catch (...) {
+        pool.release(pg_conn);
+        throw;
+    }
+}
+
+// --- Масове завантаження (COPY FROM STDIN) ---
+
+namespace {
+void append_be(string& out, uint32_t v, int len) {
+    for (int i = len - 1; i >= 0; --i) {
+        out.push_back(static_cast<char>((v >> (i * 8)) & 0xFF));
+    }
+}
+
+bool is_null_value(const optsv& v, type_t::bin_t bin) {
+    return !v || (bin != type_t::bin_t::text && v->empty());
+}
+
+// Значення вже пройшли type_t::validate, тож розбір тут не може не вдатись
+void append_binary_field(string& out, sv v, type_t::bin_t bin) {
+    switch (bin) {
+    case type_t::bin_t::int32: {
+        int32_t num = 0;
+        std::from_chars(v.data(), v.data() + v.size(), num);
+        append_be(out, 4, 4);
+        append_be(out, static_cast<uint32_t>(num), 4);
+        break;
+    }
+    case type_t::bin_t::date: {
+        using namespace std::chrono;
+        static constexpr date_t pg_epoch = sys_days{year{2000} / January / 1};
+        append_be(out, 4, 4);
+        append_be(out, static_cast<uint32_t>((*parse_iso_date(v) - pg_epoch).count()), 4);
+        break;
+    }
+    default:
+        append_be(out, static_cast<uint32_t>(v.size()), 4);
+        out.append(v);
+        break;
+    }
+}
+
+void append_text_field(string& out, sv v) {
+    for (char c : v) {
+        switch (c) {
+        case '\\': out += "\\\\"; break;
+        case '\t': out += "\\t"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        default: out.push_back(c);
+        }
+    }
+}
+} // namespace
+
+size_t SqlDrvPg::import_batch(sv table, const std::vector<ImportColumn>& columns,
+                              const std::vector<const ImportRow*>& rows) {
+    std::vector<type_t::bin_t> bins;
+    bins.reserve(columns.size());
+    for (const auto& c : columns) bins.push_back(c.type->bin());
+    const bool binary = std::none_of(bins.begin(), bins.end(),
+                                     [](type_t::bin_t b) { return b == type_t::bin_t::none; });
+
+    string sql = "COPY " + string(table) + " (";
+    for (size_t col = 0; col < columns.size(); ++col) {
+        if (col) sql += ", ";
+        sql += columns[col].name;
+    }
+    sql += binary ? ") FROM STDIN (FORMAT binary)" : ") FROM STDIN";
+
+    PgPoolRaii conn_guard(pool, tx_conn());
+    PGconn* conn = conn_guard.get()->conn;
+
+    PGresult* res = PQexec(conn, sql.c_str());
+    if (PQresultStatus(res) != PGRES_COPY_IN) {
+        string error_msg = PQerrorMessage(conn);
+        string code = sqlstate(res);
+        PQclear(res);
+        throw Error(error_msg, std::move(code));
+    }
+    PQclear(res);
+
+    // Дані відправляються частинами, буфер не росте з розміром порції
+    static constexpr size_t flush_size = 64 * 1024;
+    string buf;
+    buf.reserve(flush_size + 1024);
+    bool send_ok = true;
+    auto flush = [&] {
+        if (send_ok && !buf.empty()) {
+            send_ok = PQputCopyData(conn, buf.data(), static_cast<int>(buf.size())) == 1;
+        }
+        buf.clear();
+    };
+
+    if (binary) {
+        static constexpr char signature[] = "PGCOPY\n\377\r\n";
+        buf.append(signature, sizeof(signature));  // разом з завершальним '\0'
+        append_be(buf, 0, 4);  // прапорці
+        append_be(buf, 0, 4);  // довжина розширення заголовка
+    }
+    for (const ImportRow* row : rows) {
+        if (binary) append_be(buf, static_cast<uint32_t>(columns.size()), 2);
+        for (size_t col = 0; col < columns.size(); ++col) {
+            const optsv& v = (*row)[col];
+            if (binary) {
+                if (is_null_value(v, bins[col])) append_be(buf, 0xFFFFFFFF, 4);
+                else append_binary_field(buf, *v, bins[col]);
+            } else {
+                if (col) buf.push_back('\t');
+                if (is_null_value(v, bins[col])) buf += "\\N";
+                else append_text_field(buf, *v);
+            }
+        }
+        if (!binary) buf.push_back('\n');
+        if (buf.size() >= flush_size) flush();
+    }
+    if (binary) append_be(buf, 0xFFFF, 2);  // кінець даних
+    flush();
+
+    // Помилку відправки передаємо серверу, щоб він скасував COPY
+    PQputCopyEnd(conn, send_ok ? nullptr : "client failed to send COPY data");
+
+    string error_msg, error_code;
+    size_t imported = 0;
+    while ((res = PQgetResult(conn)) != nullptr) {
+        if (PQresultStatus(res) == PGRES_COMMAND_OK) {
+            string tuples = PQcmdTuples(res);
+            imported = tuples.empty() ? 0 : std::stoul(tuples);
+        } else if (error_msg.empty()) {
+            error_msg = PQresultErrorMessage(res);
+            error_code = sqlstate(res);
+        }
+        PQclear(res);
+    }
+    if (!error_msg.empty()) {
+        throw Error(error_msg, std::move(error_code));
+    }
+    return imported;
+}
+
+// --- Асинхронні варіанти ---
+
+// У відкритій транзакції потоку асинхронні виклики виконуються одразу на її з'єднанні:
+// через PgLoop вони пішли б іншим з'єднанням поза транзакцією і могли б чекати на її ж блокування.
+
+PgLoop& SqlDrvPg::loop() {
+    std::call_once(loop_once, [this] { async_loop = std::make_unique<PgLoop>(pool); });
+    return *async_loop;
+}
+
+std::future<std::unique_ptr<SqlDB::Result>> SqlDrvPg::query_async(sv sql, std::vector<string> params) {
+    if (tx_conn()) return run_now([&] { return query(sql, params); });
+    auto promise = std::make_shared<std::promise<std::unique_ptr<SqlDB::Result>>>();
+    auto future = promise->get_future();
+
+    std::vector<PgLoop::Stmt> stmts;
+    stmts.push_back({string(sql), std::move(params)});
+    loop().submit(std::move(stmts), [promise](std::vector<PGresult*>&& results, const string& error) {
+        if (!error.empty()) {
+            promise->set_exception(std::make_exception_ptr(std::runtime_error(error)));
+            return;
+        }
+        promise->set_value(std::make_unique<Result>(results.at(0)));
+    });
+    return future;
+}
+
+std::future<std::vector<std::unique_ptr<SqlDB::Result>>> SqlDrvPg::query_pipeline_async(const std::vector<Statement>& batch) {
+    if (tx_conn()) return run_now([&] { return query_pipeline(batch); });
+    auto promise = std::make_shared<std::promise<std::vector<std::unique_ptr<SqlDB::Result>>>>();
+    auto future = promise->get_future();
+
+    std::vector<PgLoop::Stmt> stmts;
+    stmts.reserve(batch.size());
+    for (const auto& st : batch) {
+        stmts.push_back({string(st.sql), st.params, st.once, st.binary});
+    }
+    loop().submit(std::move(stmts), [promise](std::vector<PGresult*>&& results, const string& error) {
+        if (!error.empty()) {
+            promise->set_exception(std::make_exception_ptr(std::runtime_error(error)));
+            return;
+        }
+        std::vector<std::unique_ptr<SqlDB::Result>> wrapped;
+        wrapped.reserve(results.size());
+        for (PGresult* res : results) {
+            wrapped.push_back(std::make_unique<Result>(res));
+        }
+        promise->set_value(std::move(wrapped));
+    });
+    return future;
+}
+
+std::future<int> SqlDrvPg::execute_async(sv sql, std::vector<string> params) {
+    if (tx_conn()) return run_now([&] { return execute(sql, params); });
+    auto promise = std::make_shared<std::promise<int>>();
+    auto future = promise->get_future();
+
+    std::vector<PgLoop::Stmt> stmts;
+    // Як і execute(), без кешу підготовлених запитів
+    stmts.push_back({string(sql), std::move(params), true});
+    loop().submit(std::move(stmts), [promise](std::vector<PGresult*>&& results, const string& error) {
+        if (!error.empty()) {
+            promise->set_exception(std::make_exception_ptr(std::runtime_error(error)));
+            return;
+        }
+        string tuples = PQcmdTuples(results.at(0));
+        PQclear(results.at(0));
+        promise->set_value(tuples.empty() ? 0 : std::stoi(tuples));
+    });
+    return future;
+}
+
 } // namespace ky
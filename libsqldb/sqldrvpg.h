@@ -14,8 +14,31 @@ public:
     ~SqlDrvPg() override;
 
     std::unique_ptr<SqlDB::Result> query(sv sql, const std::vector<string>& params) override;
+    std::unique_ptr<SqlDB::Result> query_once(sv sql, const std::vector<string>& params) override;
+    /// Пакет відправляється в libpq pipeline mode: всі запити та один Sync за один обмін.
+    std::vector<std::unique_ptr<SqlDB::Result>> query_pipeline(const std::vector<Statement>& batch) override;
+    /// Режим порцій libpq (PQsetChunkedRowsMode), або single-row mode для libpq < 17,
+    /// де рядки збираються в порції до chunk_rows на боці клієнта.
+    std::unique_ptr<SqlDB::Stream> query_stream(sv sql, const std::vector<string>& params, int chunk_rows) override;
     int execute(sv sql, const std::vector<string>& params) override;
 
+    // Асинхронні варіанти обслуговує один PgLoop (epoll) на весь драйвер.
+    std::future<std::unique_ptr<SqlDB::Result>> query_async(sv sql, std::vector<string> params) override;
+    std::future<std::vector<std::unique_ptr<SqlDB::Result>>> query_pipeline_async(const std::vector<Statement>& batch) override;
+    std::future<int> execute_async(sv sql, std::vector<string> params) override;
+
+    // Транзакція займає з'єднання з пулу до commit()/rollback() і прив'язує його до потоку
+    void beginTransaction() override;
+    void commit() override;
+    void rollback() override;
+    bool inTransaction() const override;
+
+protected:
+    /// Порція відправляється одним COPY ... FROM STDIN: бінарним, якщо всі колонки мають
+    /// бінарне кодування (type_t::bin()), інакше текстовим.
+    size_t import_batch(sv table, const std::vector<ImportColumn>& columns,
+                        const std::vector<const ImportRow*>& rows) override;
+
 private:
     class Result : public SqlDB::Result {
     public:
@@ -27,12 +50,52 @@ private:
         int column_count() const override;
         //string column_name(int col) const override;
         optsv get_value(int row, int col) const override;
+        // Для бінарних колонок читають значення напряму, без розбору тексту
+        std::optional<int32_t> get_int32(int row, int col) const override;
+        std::optional<int64_t> get_int64(int row, int col) const override;
+        std::optional<date_t> get_date(int row, int col) const override;
     private:
+        bool is_binary(int col) const { return PQfformat(res, col) == 1; }
+
         PGresult* res;
     };
 
+    class Stream : public SqlDB::Stream {
+    public:
+        Stream(PgPool& pool, PgConn* pinned, sv sql, const std::vector<string>& params, int chunk_rows);
+        ~Stream() override;
+
+        std::unique_ptr<SqlDB::Result> next_chunk() override;
+    private:
+        void drain();
+
+        PgPoolRaii conn_guard;  // З'єднання зайняте, поки потік не вичитано
+        const int chunk_rows;   // Рядків у порції; для single-row mode їх збирає next_chunk()
+        bool done = false;
+    };
+
+    /// Повертає підготовлений запит з кешу з'єднання, готуючи його за потреби.
+    static PgPrepStmt* prepare(PgConn* pg_conn, const ArcKey& sql);
+
+
+    /// З'єднання відкритої транзакції поточного потоку або nullptr.
+    PgConn* tx_conn() const;
+    /// COMMIT або ROLLBACK: знімає з'єднання з потоку і повертає його в пул. Повертає тег команди.
+    string end_transaction(const char* sql);
+
+    /// PgLoop створюється при першому асинхронному виклику.
+    PgLoop& loop();
+
     // Пул з'єднань як прямий член класу.
     PgPool pool;
+
+    std::atomic<size_t> tx_open{0};  // Кількість відкритих транзакцій, для швидкого tx_conn()
+    mutable std::mutex tx_mutex;
+    std::unordered_map<std::thread::id, PgConn*> tx_conns;
+
+    // Оголошено після pool: цикл зупиняється раніше, ніж знищується пул.
+    std::once_flag loop_once;
+    std::unique_ptr<PgLoop> async_loop;
 };
 
 } // namespace ky